@@ -1,3 +1,9 @@
 #!/bin/bash
-tcc -Wall -Wextra -Werror -std=c99 main.c -o build/spg.linux
-tcc -Wall -Wextra -Werror -std=c99 test.c -o build/test.linux
+tcc -Wall -Wextra -Werror -std=c99 main.c spg.c -o build/spg.linux
+tcc -Wall -Wextra -Werror -std=c99 -c spg.c -o build/spg.o
+tcc -ar build/libspg.a build/spg.o
+tcc -Wall -Wextra -Werror -std=c11 test.c -o build/test.linux
+tcc -Wall -Wextra -Werror -std=c11 -DCOMPACT test.c -o build/test_compact.linux
+tcc -Wall -Wextra -Werror -std=c11 -DINSTRUMENT test.c -o build/test_instrument.linux
+tcc -Wall -Wextra -Werror -std=c11 -DPREPROCESS test.c -o build/test_preprocess.linux
+tcc -Wall -Wextra -Werror -std=c11 -DLIBRARY test.c spg.c -o build/test_library.linux
@@ -1,7 +1,18 @@
+#ifndef FILE2_H
+#define FILE2_H
+
 #ifndef generate_properties
 #define generate_properties
 #endif
 
+#ifndef spg_skip
+#define spg_skip
+#endif
+
+#ifndef spg_redact
+#define spg_redact
+#endif
+
 typedef int custom_type;
 typedef custom_type yet_another_custom_type;
 
@@ -34,3 +45,63 @@ generate_properties struct some_other_struct {
     } ignore_me;
     int another_property;
 };
+
+generate_properties struct nested_types {
+    int matrix[2][3];
+    int **double_pointer;
+    char *names[2];
+    char rows[2][8];
+    struct {
+        int x;
+        float y;
+    } point;
+    struct {
+        int id;
+    } items[2], *no_items;
+    union {
+        int as_int;
+        char *as_string;
+        struct {
+            int x;
+        } *as_point;
+    } value;
+    struct {
+        long anonymous;
+    };
+    st *nested;
+    void (*callback)(int, char *);
+};
+
+generate_properties struct counters {
+    int hits;
+    int misses;
+    int evictions;
+    int level : 3;
+    double hit_rate;
+    double miss_rate;
+    struct {
+        long started;
+        long finished;
+    } time;
+    char grade;
+};
+
+generate_properties struct session {
+    int user_id;
+    spg_redact char *token;
+    spg_skip char *password;
+    int flags;
+};
+
+// not generated, printed by a function written by hand.
+struct external {
+    int id;
+};
+int print_external(char *dest, int n, const struct external *src);
+
+generate_properties struct with_external {
+    struct external ext;
+    int after;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef FILE3_H
+#define FILE3_H
+
+// used with --preprocess, file2.h doesn't need to be passed.
+#include "file2.h"
+
+#if 0
+generate_properties struct disabled {
+    int x;
+};
+#endif
+
+generate_properties struct preprocessed {
+    // typedef from file2.h
+    yet_another_custom_type value;
+#if defined(SPG_EXTRA_FIELD) && SPG_EXTRA_FIELD > 0
+    int extra;
+#else
+    int fallback;
+#endif
+};
+
+#endif
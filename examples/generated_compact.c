@@ -0,0 +1,678 @@
+#include <stddef.h>
+#include <stdio.h>
+int print_foo_fields_required(char *dest, int n, const struct foo *src, unsigned long long mask, int *required);
+int print_foo_fields(char *dest, int n, const struct foo *src, unsigned long long mask);
+int print_foo(char *dest, int n, const struct foo *src);
+int print_struct_as_type_fields_required(char *dest, int n, const struct struct_as_type *src, unsigned long long mask, int *required);
+int print_struct_as_type_fields(char *dest, int n, const struct struct_as_type *src, unsigned long long mask);
+int print_struct_as_type(char *dest, int n, const struct struct_as_type *src);
+int print_inline_struct_fields_required(char *dest, int n, const struct inline_struct *src, unsigned long long mask, int *required);
+int print_inline_struct_fields(char *dest, int n, const struct inline_struct *src, unsigned long long mask);
+int print_inline_struct(char *dest, int n, const struct inline_struct *src);
+int print_some_other_struct_fields_required(char *dest, int n, const struct some_other_struct *src, unsigned long long mask, int *required);
+int print_some_other_struct_fields(char *dest, int n, const struct some_other_struct *src, unsigned long long mask);
+int print_some_other_struct(char *dest, int n, const struct some_other_struct *src);
+int print_nested_types_fields_required(char *dest, int n, const struct nested_types *src, unsigned long long mask, int *required);
+int print_nested_types_fields(char *dest, int n, const struct nested_types *src, unsigned long long mask);
+int print_nested_types(char *dest, int n, const struct nested_types *src);
+int print_counters_fields_required(char *dest, int n, const struct counters *src, unsigned long long mask, int *required);
+int print_counters_fields(char *dest, int n, const struct counters *src, unsigned long long mask);
+int print_counters(char *dest, int n, const struct counters *src);
+int print_session_fields_required(char *dest, int n, const struct session *src, unsigned long long mask, int *required);
+int print_session_fields(char *dest, int n, const struct session *src, unsigned long long mask);
+int print_session(char *dest, int n, const struct session *src);
+int print_with_external_fields_required(char *dest, int n, const struct with_external *src, unsigned long long mask, int *required);
+int print_with_external_fields(char *dest, int n, const struct with_external *src, unsigned long long mask);
+int print_with_external(char *dest, int n, const struct with_external *src);
+#define spg_at(dest, n, written) ((written) < (n) ? (dest) + (written) : 0)
+#define spg_left(n, written) ((written) < (n) ? (n) - (written) : 0)
+#define spg_print_select_1(src) _Generic((src), \
+    struct foo *: print_foo, \
+    const struct foo *: print_foo, \
+    struct struct_as_type *: print_struct_as_type, \
+    const struct struct_as_type *: print_struct_as_type, \
+    struct inline_struct *: print_inline_struct, \
+    const struct inline_struct *: print_inline_struct, \
+    struct some_other_struct *: print_some_other_struct, \
+    const struct some_other_struct *: print_some_other_struct, \
+    struct nested_types *: print_nested_types, \
+    const struct nested_types *: print_nested_types, \
+    struct counters *: print_counters, \
+    const struct counters *: print_counters, \
+    struct session *: print_session, \
+    const struct session *: print_session, \
+    struct with_external *: print_with_external, \
+    const struct with_external *: print_with_external, \
+    default: 0 \
+    )
+#define spg_print(dest, n, src) spg_print_select_1(src)(dest, n, src)
+#define spg_print_fields_select_1(src) _Generic((src), \
+    struct foo *: print_foo_fields, \
+    const struct foo *: print_foo_fields, \
+    struct struct_as_type *: print_struct_as_type_fields, \
+    const struct struct_as_type *: print_struct_as_type_fields, \
+    struct inline_struct *: print_inline_struct_fields, \
+    const struct inline_struct *: print_inline_struct_fields, \
+    struct some_other_struct *: print_some_other_struct_fields, \
+    const struct some_other_struct *: print_some_other_struct_fields, \
+    struct nested_types *: print_nested_types_fields, \
+    const struct nested_types *: print_nested_types_fields, \
+    struct counters *: print_counters_fields, \
+    const struct counters *: print_counters_fields, \
+    struct session *: print_session_fields, \
+    const struct session *: print_session_fields, \
+    struct with_external *: print_with_external_fields, \
+    const struct with_external *: print_with_external_fields, \
+    default: 0 \
+    )
+#define spg_print_fields(dest, n, src, mask) spg_print_fields_select_1(src)(dest, n, src, mask)
+#define spg_print_fields_required_select_1(src) _Generic((src), \
+    struct foo *: print_foo_fields_required, \
+    const struct foo *: print_foo_fields_required, \
+    struct struct_as_type *: print_struct_as_type_fields_required, \
+    const struct struct_as_type *: print_struct_as_type_fields_required, \
+    struct inline_struct *: print_inline_struct_fields_required, \
+    const struct inline_struct *: print_inline_struct_fields_required, \
+    struct some_other_struct *: print_some_other_struct_fields_required, \
+    const struct some_other_struct *: print_some_other_struct_fields_required, \
+    struct nested_types *: print_nested_types_fields_required, \
+    const struct nested_types *: print_nested_types_fields_required, \
+    struct counters *: print_counters_fields_required, \
+    const struct counters *: print_counters_fields_required, \
+    struct session *: print_session_fields_required, \
+    const struct session *: print_session_fields_required, \
+    struct with_external *: print_with_external_fields_required, \
+    const struct with_external *: print_with_external_fields_required, \
+    default: 0 \
+    )
+#define spg_print_fields_required(dest, n, src, mask, required) spg_print_fields_required_select_1(src)(dest, n, src, mask, required)
+#define spg_print_buf(buf, src) spg_print(buf, (int) sizeof(buf), src)
+#define spg_print_fields_buf(buf, src, mask) spg_print_fields(buf, (int) sizeof(buf), src, mask)
+#define spg_field_foo_bar (1ULL << 0)
+#define spg_field_foo_baz (1ULL << 1)
+#ifndef SPG_TABLE_FIELD
+#define SPG_TABLE_FIELD
+struct spg_table_field {
+    const char *label;
+    size_t offset;
+    unsigned long long mask;
+    int (*print)(char *dest, size_t n, const char *label, const void *value);
+};
+static int spg_print_table(char *dest, int n, const void *src, const struct spg_table_field *fields, size_t count, unsigned long long mask, int measure, int *written)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (!(mask & fields[i].mask)) continue;
+        if (*written >= n - 1 && !measure) { *written = n; return 1; }
+        int tmp = fields[i].print(spg_at(dest, n, *written), spg_left(n, *written), fields[i].label, (const char *) src + fields[i].offset);
+        if (tmp > 0) *written += tmp;
+    }
+    return 0;
+}
+#endif
+#ifndef spg_table_int
+#define spg_table_int spg_table_int
+static int spg_table_int(char *dest, size_t n, const char *label, const void *value)
+{
+    return snprintf(dest, n, "%s: %d\n", label, *(const int *) value);
+}
+#endif
+#ifndef spg_table_string
+#define spg_table_string spg_table_string
+static int spg_table_string(char *dest, size_t n, const char *label, const void *value)
+{
+    const char *text = *(const char *const *) value;
+    return text ? snprintf(dest, n, "%s: %s\n", label, text) : snprintf(dest, n, "%s: NULL\n", label);
+}
+#endif
+int print_foo_fields_required(char *dest, int n, const struct foo *src, unsigned long long mask, int *required)
+{
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    (void) tmp;
+    if (n <= 0 && !required) goto done;
+    {
+    static const struct spg_table_field fields[] = {
+        {"bar", offsetof(struct foo, bar), 1ULL << 0, spg_table_int},
+        {"baz", offsetof(struct foo, baz), 1ULL << 1, spg_table_string},
+    };
+    if (spg_print_table(dest, n, src, fields, sizeof(fields) / sizeof(*fields), mask, required != 0, &written)) goto done;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    return written;
+}
+int print_foo_fields(char *dest, int n, const struct foo *src, unsigned long long mask)
+{
+    return print_foo_fields_required(dest, n, src, mask, 0);
+}
+int print_foo(char *dest, int n, const struct foo *src)
+{
+    return print_foo_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_struct_as_type_foo (1ULL << 0)
+int print_struct_as_type_fields_required(char *dest, int n, const struct struct_as_type *src, unsigned long long mask, int *required)
+{
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    (void) tmp;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "foo: %d\n", src->foo);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    return written;
+}
+int print_struct_as_type_fields(char *dest, int n, const struct struct_as_type *src, unsigned long long mask)
+{
+    return print_struct_as_type_fields_required(dest, n, src, mask, 0);
+}
+int print_struct_as_type(char *dest, int n, const struct struct_as_type *src)
+{
+    return print_struct_as_type_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_inline_struct_baz (1ULL << 0)
+int print_inline_struct_fields_required(char *dest, int n, const struct inline_struct *src, unsigned long long mask, int *required)
+{
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    (void) tmp;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "baz: %d\n", src->baz);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    return written;
+}
+int print_inline_struct_fields(char *dest, int n, const struct inline_struct *src, unsigned long long mask)
+{
+    return print_inline_struct_fields_required(dest, n, src, mask, 0);
+}
+int print_inline_struct(char *dest, int n, const struct inline_struct *src)
+{
+    return print_inline_struct_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_some_other_struct_bar (1ULL << 0)
+#define spg_field_some_other_struct_dynamic_string (1ULL << 1)
+#define spg_field_some_other_struct_null_string (1ULL << 2)
+#define spg_field_some_other_struct_fixed_string (1ULL << 3)
+#define spg_field_some_other_struct_size_t_property (1ULL << 4)
+#define spg_field_some_other_struct_sint (1ULL << 5)
+#define spg_field_some_other_struct_uint (1ULL << 6)
+#define spg_field_some_other_struct_custom_type (1ULL << 7)
+#define spg_field_some_other_struct_st (1ULL << 8)
+#define spg_field_some_other_struct_is (1ULL << 9)
+#define spg_field_some_other_struct_ignore_me (1ULL << 10)
+#define spg_field_some_other_struct_another_property (1ULL << 11)
+#ifndef spg_table_size_t
+#define spg_table_size_t spg_table_size_t
+static int spg_table_size_t(char *dest, size_t n, const char *label, const void *value)
+{
+    return snprintf(dest, n, "%s: %ld\n", label, *(const size_t *) value);
+}
+#endif
+#ifndef spg_table_signed_int
+#define spg_table_signed_int spg_table_signed_int
+static int spg_table_signed_int(char *dest, size_t n, const char *label, const void *value)
+{
+    return snprintf(dest, n, "%s: %d\n", label, *(const signed int *) value);
+}
+#endif
+#ifndef spg_table_unsigned_int
+#define spg_table_unsigned_int spg_table_unsigned_int
+static int spg_table_unsigned_int(char *dest, size_t n, const char *label, const void *value)
+{
+    return snprintf(dest, n, "%s: %d\n", label, *(const unsigned int *) value);
+}
+#endif
+#ifndef spg_table_yet_another_custom_type
+#define spg_table_yet_another_custom_type spg_table_yet_another_custom_type
+static int spg_table_yet_another_custom_type(char *dest, size_t n, const char *label, const void *value)
+{
+    return snprintf(dest, n, "%s: %d\n", label, *(const yet_another_custom_type *) value);
+}
+#endif
+int print_some_other_struct_fields_required(char *dest, int n, const struct some_other_struct *src, unsigned long long mask, int *required)
+{
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    (void) tmp;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    for (size_t i0 = 0; i0 < 4; i0++)
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "bar: %d\n", src->bar[i0]);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    static const struct spg_table_field fields[] = {
+        {"dynamic_string", offsetof(struct some_other_struct, dynamic_string), 1ULL << 1, spg_table_string},
+        {"null_string", offsetof(struct some_other_struct, null_string), 1ULL << 2, spg_table_string},
+    };
+    if (spg_print_table(dest, n, src, fields, sizeof(fields) / sizeof(*fields), mask, required != 0, &written)) goto done;
+    }
+    if (mask & (1ULL << 3))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "fixed_string: %.*s\n", (int) sizeof(src->fixed_string), src->fixed_string);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    static const struct spg_table_field fields[] = {
+        {"size_t_property", offsetof(struct some_other_struct, size_t_property), 1ULL << 4, spg_table_size_t},
+        {"sint", offsetof(struct some_other_struct, sint), 1ULL << 5, spg_table_signed_int},
+        {"uint", offsetof(struct some_other_struct, uint), 1ULL << 6, spg_table_unsigned_int},
+        {"custom_type", offsetof(struct some_other_struct, custom_type), 1ULL << 7, spg_table_yet_another_custom_type},
+    };
+    if (spg_print_table(dest, n, src, fields, sizeof(fields) / sizeof(*fields), mask, required != 0, &written)) goto done;
+    }
+    if (mask & (1ULL << 8))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "st.");
+    if (tmp > 0) written += tmp;
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    if (required)
+        spg_print_fields_required(spg_at(dest, n, written), spg_left(n, written), &src->st, ~0ULL, &tmp);
+    else
+        tmp = spg_print(spg_at(dest, n, written), spg_left(n, written), &src->st);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 9))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "is.");
+    if (tmp > 0) written += tmp;
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    if (required)
+        spg_print_fields_required(spg_at(dest, n, written), spg_left(n, written), &src->is, ~0ULL, &tmp);
+    else
+        tmp = spg_print(spg_at(dest, n, written), spg_left(n, written), &src->is);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 10))
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "ignore_me.foo: %d\n", src->ignore_me.foo);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    if (mask & (1ULL << 11))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "another_property: %d\n", src->another_property);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    return written;
+}
+int print_some_other_struct_fields(char *dest, int n, const struct some_other_struct *src, unsigned long long mask)
+{
+    return print_some_other_struct_fields_required(dest, n, src, mask, 0);
+}
+int print_some_other_struct(char *dest, int n, const struct some_other_struct *src)
+{
+    return print_some_other_struct_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_nested_types_matrix (1ULL << 0)
+#define spg_field_nested_types_double_pointer (1ULL << 1)
+#define spg_field_nested_types_names (1ULL << 2)
+#define spg_field_nested_types_rows (1ULL << 3)
+#define spg_field_nested_types_point (1ULL << 4)
+#define spg_field_nested_types_items (1ULL << 5)
+#define spg_field_nested_types_no_items (1ULL << 6)
+#define spg_field_nested_types_value (1ULL << 7)
+#define spg_field_nested_types_nested (1ULL << 8)
+#ifndef spg_table_float
+#define spg_table_float spg_table_float
+static int spg_table_float(char *dest, size_t n, const char *label, const void *value)
+{
+    return snprintf(dest, n, "%s: %f\n", label, *(const float *) value);
+}
+#endif
+int print_nested_types_fields_required(char *dest, int n, const struct nested_types *src, unsigned long long mask, int *required)
+{
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    (void) tmp;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    for (size_t i0 = 0; i0 < 2; i0++)
+    for (size_t i1 = 0; i1 < 3; i1++)
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "matrix: %d\n", src->matrix[i0][i1]);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->double_pointer && *src->double_pointer)
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "double_pointer: %d\n", **src->double_pointer);
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "double_pointer: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 2))
+    for (size_t i0 = 0; i0 < 2; i0++)
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->names[i0])
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "names: %s\n", src->names[i0]);
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "names: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 3))
+    for (size_t i0 = 0; i0 < 2; i0++)
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "rows: %.*s\n", (int) sizeof(src->rows[i0]), src->rows[i0]);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 4))
+    {
+    {
+    static const struct spg_table_field fields[] = {
+        {"point.x", offsetof(struct nested_types, point.x), ~0ULL, spg_table_int},
+        {"point.y", offsetof(struct nested_types, point.y), ~0ULL, spg_table_float},
+    };
+    if (spg_print_table(dest, n, src, fields, sizeof(fields) / sizeof(*fields), mask, required != 0, &written)) goto done;
+    }
+    }
+    if (mask & (1ULL << 5))
+    for (size_t i0 = 0; i0 < 2; i0++)
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "items.id: %d\n", src->items[i0].id);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    if (mask & (1ULL << 6))
+    {
+    if (src->no_items)
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "no_items.id: %d\n", src->no_items->id);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    else
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "no_items: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+    }
+    if (mask & (1ULL << 7))
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "value.as_int: %d\n", src->value.as_int);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "value.as_string: %p\n", (void *) src->value.as_string);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "value.as_point: %p\n", (void *) src->value.as_point);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "anonymous: %ld\n", src->anonymous);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 8))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->nested)
+    {
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "nested.");
+    if (tmp > 0) written += tmp;
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    if (required)
+        spg_print_fields_required(spg_at(dest, n, written), spg_left(n, written), src->nested, ~0ULL, &tmp);
+    else
+        tmp = spg_print(spg_at(dest, n, written), spg_left(n, written), src->nested);
+    }
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "nested: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    return written;
+}
+int print_nested_types_fields(char *dest, int n, const struct nested_types *src, unsigned long long mask)
+{
+    return print_nested_types_fields_required(dest, n, src, mask, 0);
+}
+int print_nested_types(char *dest, int n, const struct nested_types *src)
+{
+    return print_nested_types_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_counters_hits (1ULL << 0)
+#define spg_field_counters_misses (1ULL << 1)
+#define spg_field_counters_evictions (1ULL << 2)
+#define spg_field_counters_level (1ULL << 3)
+#define spg_field_counters_hit_rate (1ULL << 4)
+#define spg_field_counters_miss_rate (1ULL << 5)
+#define spg_field_counters_time (1ULL << 6)
+#define spg_field_counters_grade (1ULL << 7)
+#ifndef spg_table_double
+#define spg_table_double spg_table_double
+static int spg_table_double(char *dest, size_t n, const char *label, const void *value)
+{
+    return snprintf(dest, n, "%s: %f\n", label, *(const double *) value);
+}
+#endif
+#ifndef spg_table_long
+#define spg_table_long spg_table_long
+static int spg_table_long(char *dest, size_t n, const char *label, const void *value)
+{
+    return snprintf(dest, n, "%s: %ld\n", label, *(const long *) value);
+}
+#endif
+int print_counters_fields_required(char *dest, int n, const struct counters *src, unsigned long long mask, int *required)
+{
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    (void) tmp;
+    if (n <= 0 && !required) goto done;
+    {
+    static const struct spg_table_field fields[] = {
+        {"hits", offsetof(struct counters, hits), 1ULL << 0, spg_table_int},
+        {"misses", offsetof(struct counters, misses), 1ULL << 1, spg_table_int},
+        {"evictions", offsetof(struct counters, evictions), 1ULL << 2, spg_table_int},
+    };
+    if (spg_print_table(dest, n, src, fields, sizeof(fields) / sizeof(*fields), mask, required != 0, &written)) goto done;
+    }
+    if (mask & (1ULL << 3))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "level: %d\n", src->level);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    static const struct spg_table_field fields[] = {
+        {"hit_rate", offsetof(struct counters, hit_rate), 1ULL << 4, spg_table_double},
+        {"miss_rate", offsetof(struct counters, miss_rate), 1ULL << 5, spg_table_double},
+    };
+    if (spg_print_table(dest, n, src, fields, sizeof(fields) / sizeof(*fields), mask, required != 0, &written)) goto done;
+    }
+    if (mask & (1ULL << 6))
+    {
+    {
+    static const struct spg_table_field fields[] = {
+        {"time.started", offsetof(struct counters, time.started), ~0ULL, spg_table_long},
+        {"time.finished", offsetof(struct counters, time.finished), ~0ULL, spg_table_long},
+    };
+    if (spg_print_table(dest, n, src, fields, sizeof(fields) / sizeof(*fields), mask, required != 0, &written)) goto done;
+    }
+    }
+    if (mask & (1ULL << 7))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "grade: %c\n", src->grade);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    return written;
+}
+int print_counters_fields(char *dest, int n, const struct counters *src, unsigned long long mask)
+{
+    return print_counters_fields_required(dest, n, src, mask, 0);
+}
+int print_counters(char *dest, int n, const struct counters *src)
+{
+    return print_counters_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_session_user_id (1ULL << 0)
+#define spg_field_session_token (1ULL << 1)
+#define spg_field_session_flags (1ULL << 2)
+int print_session_fields_required(char *dest, int n, const struct session *src, unsigned long long mask, int *required)
+{
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    (void) tmp;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "user_id: %d\n", src->user_id);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "token: [redacted]\n");
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 2))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "flags: %d\n", src->flags);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    return written;
+}
+int print_session_fields(char *dest, int n, const struct session *src, unsigned long long mask)
+{
+    return print_session_fields_required(dest, n, src, mask, 0);
+}
+int print_session(char *dest, int n, const struct session *src)
+{
+    return print_session_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_with_external_ext (1ULL << 0)
+#define spg_field_with_external_after (1ULL << 1)
+int print_with_external_fields_required(char *dest, int n, const struct with_external *src, unsigned long long mask, int *required)
+{
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    (void) tmp;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "ext.");
+    if (tmp > 0) written += tmp;
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = print_external(spg_at(dest, n, written), spg_left(n, written), &src->ext);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "after: %d\n", src->after);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    return written;
+}
+int print_with_external_fields(char *dest, int n, const struct with_external *src, unsigned long long mask)
+{
+    return print_with_external_fields_required(dest, n, src, mask, 0);
+}
+int print_with_external(char *dest, int n, const struct with_external *src)
+{
+    return print_with_external_fields_required(dest, n, src, ~0ULL, 0);
+}
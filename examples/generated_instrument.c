@@ -0,0 +1,742 @@
+#include <stddef.h>
+#include <stdio.h>
+#ifndef SPG_STATS
+#define SPG_STATS
+struct spg_stats {
+    const char *name;
+    unsigned long long calls;
+    unsigned long long bytes;
+    unsigned long long truncations;
+    unsigned long long cycles;
+};
+#if defined(SPG_RDTSC) && defined(_MSC_VER)
+#include <intrin.h>
+#define spg_cycles() __rdtsc()
+#elif defined(SPG_RDTSC) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define spg_cycles() __rdtsc()
+#else
+#define spg_cycles() 0ULL
+#endif
+#endif
+int print_foo_fields_required(char *dest, int n, const struct foo *src, unsigned long long mask, int *required);
+int print_foo_fields(char *dest, int n, const struct foo *src, unsigned long long mask);
+int print_foo(char *dest, int n, const struct foo *src);
+int print_struct_as_type_fields_required(char *dest, int n, const struct struct_as_type *src, unsigned long long mask, int *required);
+int print_struct_as_type_fields(char *dest, int n, const struct struct_as_type *src, unsigned long long mask);
+int print_struct_as_type(char *dest, int n, const struct struct_as_type *src);
+int print_inline_struct_fields_required(char *dest, int n, const struct inline_struct *src, unsigned long long mask, int *required);
+int print_inline_struct_fields(char *dest, int n, const struct inline_struct *src, unsigned long long mask);
+int print_inline_struct(char *dest, int n, const struct inline_struct *src);
+int print_some_other_struct_fields_required(char *dest, int n, const struct some_other_struct *src, unsigned long long mask, int *required);
+int print_some_other_struct_fields(char *dest, int n, const struct some_other_struct *src, unsigned long long mask);
+int print_some_other_struct(char *dest, int n, const struct some_other_struct *src);
+int print_nested_types_fields_required(char *dest, int n, const struct nested_types *src, unsigned long long mask, int *required);
+int print_nested_types_fields(char *dest, int n, const struct nested_types *src, unsigned long long mask);
+int print_nested_types(char *dest, int n, const struct nested_types *src);
+int print_counters_fields_required(char *dest, int n, const struct counters *src, unsigned long long mask, int *required);
+int print_counters_fields(char *dest, int n, const struct counters *src, unsigned long long mask);
+int print_counters(char *dest, int n, const struct counters *src);
+int print_session_fields_required(char *dest, int n, const struct session *src, unsigned long long mask, int *required);
+int print_session_fields(char *dest, int n, const struct session *src, unsigned long long mask);
+int print_session(char *dest, int n, const struct session *src);
+int print_with_external_fields_required(char *dest, int n, const struct with_external *src, unsigned long long mask, int *required);
+int print_with_external_fields(char *dest, int n, const struct with_external *src, unsigned long long mask);
+int print_with_external(char *dest, int n, const struct with_external *src);
+#define spg_at(dest, n, written) ((written) < (n) ? (dest) + (written) : 0)
+#define spg_left(n, written) ((written) < (n) ? (n) - (written) : 0)
+#define spg_print_select_1(src) _Generic((src), \
+    struct foo *: print_foo, \
+    const struct foo *: print_foo, \
+    struct struct_as_type *: print_struct_as_type, \
+    const struct struct_as_type *: print_struct_as_type, \
+    struct inline_struct *: print_inline_struct, \
+    const struct inline_struct *: print_inline_struct, \
+    struct some_other_struct *: print_some_other_struct, \
+    const struct some_other_struct *: print_some_other_struct, \
+    struct nested_types *: print_nested_types, \
+    const struct nested_types *: print_nested_types, \
+    struct counters *: print_counters, \
+    const struct counters *: print_counters, \
+    struct session *: print_session, \
+    const struct session *: print_session, \
+    struct with_external *: print_with_external, \
+    const struct with_external *: print_with_external, \
+    default: 0 \
+    )
+#define spg_print(dest, n, src) spg_print_select_1(src)(dest, n, src)
+#define spg_print_fields_select_1(src) _Generic((src), \
+    struct foo *: print_foo_fields, \
+    const struct foo *: print_foo_fields, \
+    struct struct_as_type *: print_struct_as_type_fields, \
+    const struct struct_as_type *: print_struct_as_type_fields, \
+    struct inline_struct *: print_inline_struct_fields, \
+    const struct inline_struct *: print_inline_struct_fields, \
+    struct some_other_struct *: print_some_other_struct_fields, \
+    const struct some_other_struct *: print_some_other_struct_fields, \
+    struct nested_types *: print_nested_types_fields, \
+    const struct nested_types *: print_nested_types_fields, \
+    struct counters *: print_counters_fields, \
+    const struct counters *: print_counters_fields, \
+    struct session *: print_session_fields, \
+    const struct session *: print_session_fields, \
+    struct with_external *: print_with_external_fields, \
+    const struct with_external *: print_with_external_fields, \
+    default: 0 \
+    )
+#define spg_print_fields(dest, n, src, mask) spg_print_fields_select_1(src)(dest, n, src, mask)
+#define spg_print_fields_required_select_1(src) _Generic((src), \
+    struct foo *: print_foo_fields_required, \
+    const struct foo *: print_foo_fields_required, \
+    struct struct_as_type *: print_struct_as_type_fields_required, \
+    const struct struct_as_type *: print_struct_as_type_fields_required, \
+    struct inline_struct *: print_inline_struct_fields_required, \
+    const struct inline_struct *: print_inline_struct_fields_required, \
+    struct some_other_struct *: print_some_other_struct_fields_required, \
+    const struct some_other_struct *: print_some_other_struct_fields_required, \
+    struct nested_types *: print_nested_types_fields_required, \
+    const struct nested_types *: print_nested_types_fields_required, \
+    struct counters *: print_counters_fields_required, \
+    const struct counters *: print_counters_fields_required, \
+    struct session *: print_session_fields_required, \
+    const struct session *: print_session_fields_required, \
+    struct with_external *: print_with_external_fields_required, \
+    const struct with_external *: print_with_external_fields_required, \
+    default: 0 \
+    )
+#define spg_print_fields_required(dest, n, src, mask, required) spg_print_fields_required_select_1(src)(dest, n, src, mask, required)
+#define spg_print_buf(buf, src) spg_print(buf, (int) sizeof(buf), src)
+#define spg_print_fields_buf(buf, src, mask) spg_print_fields(buf, (int) sizeof(buf), src, mask)
+#define spg_field_foo_bar (1ULL << 0)
+#define spg_field_foo_baz (1ULL << 1)
+static struct spg_stats spg_stats_foo = {"foo", 0, 0, 0, 0};
+int print_foo_fields_required(char *dest, int n, const struct foo *src, unsigned long long mask, int *required)
+{
+    spg_stats_foo.calls++;
+    unsigned long long spg_start = spg_cycles();
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "bar: %d\n", src->bar);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->baz)
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "baz: %s\n", src->baz);
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "baz: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) spg_stats_foo.truncations++;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    spg_stats_foo.bytes += written;
+    spg_stats_foo.cycles += spg_cycles() - spg_start;
+    return written;
+}
+int print_foo_fields(char *dest, int n, const struct foo *src, unsigned long long mask)
+{
+    return print_foo_fields_required(dest, n, src, mask, 0);
+}
+int print_foo(char *dest, int n, const struct foo *src)
+{
+    return print_foo_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_struct_as_type_foo (1ULL << 0)
+static struct spg_stats spg_stats_struct_as_type = {"struct_as_type", 0, 0, 0, 0};
+int print_struct_as_type_fields_required(char *dest, int n, const struct struct_as_type *src, unsigned long long mask, int *required)
+{
+    spg_stats_struct_as_type.calls++;
+    unsigned long long spg_start = spg_cycles();
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "foo: %d\n", src->foo);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) spg_stats_struct_as_type.truncations++;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    spg_stats_struct_as_type.bytes += written;
+    spg_stats_struct_as_type.cycles += spg_cycles() - spg_start;
+    return written;
+}
+int print_struct_as_type_fields(char *dest, int n, const struct struct_as_type *src, unsigned long long mask)
+{
+    return print_struct_as_type_fields_required(dest, n, src, mask, 0);
+}
+int print_struct_as_type(char *dest, int n, const struct struct_as_type *src)
+{
+    return print_struct_as_type_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_inline_struct_baz (1ULL << 0)
+static struct spg_stats spg_stats_inline_struct = {"inline_struct", 0, 0, 0, 0};
+int print_inline_struct_fields_required(char *dest, int n, const struct inline_struct *src, unsigned long long mask, int *required)
+{
+    spg_stats_inline_struct.calls++;
+    unsigned long long spg_start = spg_cycles();
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "baz: %d\n", src->baz);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) spg_stats_inline_struct.truncations++;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    spg_stats_inline_struct.bytes += written;
+    spg_stats_inline_struct.cycles += spg_cycles() - spg_start;
+    return written;
+}
+int print_inline_struct_fields(char *dest, int n, const struct inline_struct *src, unsigned long long mask)
+{
+    return print_inline_struct_fields_required(dest, n, src, mask, 0);
+}
+int print_inline_struct(char *dest, int n, const struct inline_struct *src)
+{
+    return print_inline_struct_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_some_other_struct_bar (1ULL << 0)
+#define spg_field_some_other_struct_dynamic_string (1ULL << 1)
+#define spg_field_some_other_struct_null_string (1ULL << 2)
+#define spg_field_some_other_struct_fixed_string (1ULL << 3)
+#define spg_field_some_other_struct_size_t_property (1ULL << 4)
+#define spg_field_some_other_struct_sint (1ULL << 5)
+#define spg_field_some_other_struct_uint (1ULL << 6)
+#define spg_field_some_other_struct_custom_type (1ULL << 7)
+#define spg_field_some_other_struct_st (1ULL << 8)
+#define spg_field_some_other_struct_is (1ULL << 9)
+#define spg_field_some_other_struct_ignore_me (1ULL << 10)
+#define spg_field_some_other_struct_another_property (1ULL << 11)
+static struct spg_stats spg_stats_some_other_struct = {"some_other_struct", 0, 0, 0, 0};
+int print_some_other_struct_fields_required(char *dest, int n, const struct some_other_struct *src, unsigned long long mask, int *required)
+{
+    spg_stats_some_other_struct.calls++;
+    unsigned long long spg_start = spg_cycles();
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    for (size_t i0 = 0; i0 < 4; i0++)
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "bar: %d\n", src->bar[i0]);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->dynamic_string)
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "dynamic_string: %s\n", src->dynamic_string);
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "dynamic_string: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 2))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->null_string)
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "null_string: %s\n", src->null_string);
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "null_string: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 3))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "fixed_string: %.*s\n", (int) sizeof(src->fixed_string), src->fixed_string);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 4))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "size_t_property: %ld\n", src->size_t_property);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 5))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "sint: %d\n", src->sint);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 6))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "uint: %d\n", src->uint);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 7))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "custom_type: %d\n", src->custom_type);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 8))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "st.");
+    if (tmp > 0) written += tmp;
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    if (required)
+        spg_print_fields_required(spg_at(dest, n, written), spg_left(n, written), &src->st, ~0ULL, &tmp);
+    else
+        tmp = spg_print(spg_at(dest, n, written), spg_left(n, written), &src->st);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 9))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "is.");
+    if (tmp > 0) written += tmp;
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    if (required)
+        spg_print_fields_required(spg_at(dest, n, written), spg_left(n, written), &src->is, ~0ULL, &tmp);
+    else
+        tmp = spg_print(spg_at(dest, n, written), spg_left(n, written), &src->is);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 10))
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "ignore_me.foo: %d\n", src->ignore_me.foo);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    if (mask & (1ULL << 11))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "another_property: %d\n", src->another_property);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) spg_stats_some_other_struct.truncations++;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    spg_stats_some_other_struct.bytes += written;
+    spg_stats_some_other_struct.cycles += spg_cycles() - spg_start;
+    return written;
+}
+int print_some_other_struct_fields(char *dest, int n, const struct some_other_struct *src, unsigned long long mask)
+{
+    return print_some_other_struct_fields_required(dest, n, src, mask, 0);
+}
+int print_some_other_struct(char *dest, int n, const struct some_other_struct *src)
+{
+    return print_some_other_struct_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_nested_types_matrix (1ULL << 0)
+#define spg_field_nested_types_double_pointer (1ULL << 1)
+#define spg_field_nested_types_names (1ULL << 2)
+#define spg_field_nested_types_rows (1ULL << 3)
+#define spg_field_nested_types_point (1ULL << 4)
+#define spg_field_nested_types_items (1ULL << 5)
+#define spg_field_nested_types_no_items (1ULL << 6)
+#define spg_field_nested_types_value (1ULL << 7)
+#define spg_field_nested_types_nested (1ULL << 8)
+static struct spg_stats spg_stats_nested_types = {"nested_types", 0, 0, 0, 0};
+int print_nested_types_fields_required(char *dest, int n, const struct nested_types *src, unsigned long long mask, int *required)
+{
+    spg_stats_nested_types.calls++;
+    unsigned long long spg_start = spg_cycles();
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    for (size_t i0 = 0; i0 < 2; i0++)
+    for (size_t i1 = 0; i1 < 3; i1++)
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "matrix: %d\n", src->matrix[i0][i1]);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->double_pointer && *src->double_pointer)
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "double_pointer: %d\n", **src->double_pointer);
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "double_pointer: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 2))
+    for (size_t i0 = 0; i0 < 2; i0++)
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->names[i0])
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "names: %s\n", src->names[i0]);
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "names: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 3))
+    for (size_t i0 = 0; i0 < 2; i0++)
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "rows: %.*s\n", (int) sizeof(src->rows[i0]), src->rows[i0]);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 4))
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "point.x: %d\n", src->point.x);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "point.y: %f\n", src->point.y);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    if (mask & (1ULL << 5))
+    for (size_t i0 = 0; i0 < 2; i0++)
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "items.id: %d\n", src->items[i0].id);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    if (mask & (1ULL << 6))
+    {
+    if (src->no_items)
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "no_items.id: %d\n", src->no_items->id);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    else
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "no_items: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+    }
+    if (mask & (1ULL << 7))
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "value.as_int: %d\n", src->value.as_int);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "value.as_string: %p\n", (void *) src->value.as_string);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "value.as_point: %p\n", (void *) src->value.as_point);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "anonymous: %ld\n", src->anonymous);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 8))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    if (src->nested)
+    {
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "nested.");
+    if (tmp > 0) written += tmp;
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    if (required)
+        spg_print_fields_required(spg_at(dest, n, written), spg_left(n, written), src->nested, ~0ULL, &tmp);
+    else
+        tmp = spg_print(spg_at(dest, n, written), spg_left(n, written), src->nested);
+    }
+    else
+        tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "nested: NULL\n");
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) spg_stats_nested_types.truncations++;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    spg_stats_nested_types.bytes += written;
+    spg_stats_nested_types.cycles += spg_cycles() - spg_start;
+    return written;
+}
+int print_nested_types_fields(char *dest, int n, const struct nested_types *src, unsigned long long mask)
+{
+    return print_nested_types_fields_required(dest, n, src, mask, 0);
+}
+int print_nested_types(char *dest, int n, const struct nested_types *src)
+{
+    return print_nested_types_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_counters_hits (1ULL << 0)
+#define spg_field_counters_misses (1ULL << 1)
+#define spg_field_counters_evictions (1ULL << 2)
+#define spg_field_counters_level (1ULL << 3)
+#define spg_field_counters_hit_rate (1ULL << 4)
+#define spg_field_counters_miss_rate (1ULL << 5)
+#define spg_field_counters_time (1ULL << 6)
+#define spg_field_counters_grade (1ULL << 7)
+static struct spg_stats spg_stats_counters = {"counters", 0, 0, 0, 0};
+int print_counters_fields_required(char *dest, int n, const struct counters *src, unsigned long long mask, int *required)
+{
+    spg_stats_counters.calls++;
+    unsigned long long spg_start = spg_cycles();
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "hits: %d\n", src->hits);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "misses: %d\n", src->misses);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 2))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "evictions: %d\n", src->evictions);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 3))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "level: %d\n", src->level);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 4))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "hit_rate: %f\n", src->hit_rate);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 5))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "miss_rate: %f\n", src->miss_rate);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 6))
+    {
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "time.started: %ld\n", src->time.started);
+    if (tmp > 0) written += tmp;
+    }
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "time.finished: %ld\n", src->time.finished);
+    if (tmp > 0) written += tmp;
+    }
+    }
+    if (mask & (1ULL << 7))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "grade: %c\n", src->grade);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) spg_stats_counters.truncations++;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    spg_stats_counters.bytes += written;
+    spg_stats_counters.cycles += spg_cycles() - spg_start;
+    return written;
+}
+int print_counters_fields(char *dest, int n, const struct counters *src, unsigned long long mask)
+{
+    return print_counters_fields_required(dest, n, src, mask, 0);
+}
+int print_counters(char *dest, int n, const struct counters *src)
+{
+    return print_counters_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_session_user_id (1ULL << 0)
+#define spg_field_session_token (1ULL << 1)
+#define spg_field_session_flags (1ULL << 2)
+static struct spg_stats spg_stats_session = {"session", 0, 0, 0, 0};
+int print_session_fields_required(char *dest, int n, const struct session *src, unsigned long long mask, int *required)
+{
+    spg_stats_session.calls++;
+    unsigned long long spg_start = spg_cycles();
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "user_id: %d\n", src->user_id);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "token: [redacted]\n");
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 2))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "flags: %d\n", src->flags);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) spg_stats_session.truncations++;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    spg_stats_session.bytes += written;
+    spg_stats_session.cycles += spg_cycles() - spg_start;
+    return written;
+}
+int print_session_fields(char *dest, int n, const struct session *src, unsigned long long mask)
+{
+    return print_session_fields_required(dest, n, src, mask, 0);
+}
+int print_session(char *dest, int n, const struct session *src)
+{
+    return print_session_fields_required(dest, n, src, ~0ULL, 0);
+}
+#define spg_field_with_external_ext (1ULL << 0)
+#define spg_field_with_external_after (1ULL << 1)
+static struct spg_stats spg_stats_with_external = {"with_external", 0, 0, 0, 0};
+int print_with_external_fields_required(char *dest, int n, const struct with_external *src, unsigned long long mask, int *required)
+{
+    spg_stats_with_external.calls++;
+    unsigned long long spg_start = spg_cycles();
+    if (required) *required = 0;
+    if (!src || (!dest && n > 0)) return 0;
+    int written = 0;
+    int tmp = 0;
+    if (n <= 0 && !required) goto done;
+    if (mask & (1ULL << 0))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "ext.");
+    if (tmp > 0) written += tmp;
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = print_external(spg_at(dest, n, written), spg_left(n, written), &src->ext);
+    if (tmp > 0) written += tmp;
+    }
+    if (mask & (1ULL << 1))
+    {
+    if (written >= n - 1 && !required) { written = n; goto done; }
+    tmp = 0;
+    tmp = snprintf(spg_at(dest, n, written), spg_left(n, written), "after: %d\n", src->after);
+    if (tmp > 0) written += tmp;
+    }
+done:
+    if (required) *required = written;
+    if (written >= n) spg_stats_with_external.truncations++;
+    if (written >= n) written = n > 0 ? n - 1 : 0;
+    if (n > 0) dest[written] = 0;
+    spg_stats_with_external.bytes += written;
+    spg_stats_with_external.cycles += spg_cycles() - spg_start;
+    return written;
+}
+int print_with_external_fields(char *dest, int n, const struct with_external *src, unsigned long long mask)
+{
+    return print_with_external_fields_required(dest, n, src, mask, 0);
+}
+int print_with_external(char *dest, int n, const struct with_external *src)
+{
+    return print_with_external_fields_required(dest, n, src, ~0ULL, 0);
+}
+static struct spg_stats *spg_stats_table[] = {
+    &spg_stats_foo,
+    &spg_stats_struct_as_type,
+    &spg_stats_inline_struct,
+    &spg_stats_some_other_struct,
+    &spg_stats_nested_types,
+    &spg_stats_counters,
+    &spg_stats_session,
+    &spg_stats_with_external,
+    0,
+};
+void spg_dump_stats(FILE *out)
+{
+    for (struct spg_stats **stats = spg_stats_table; *stats; stats++)
+        fprintf(out, "%s: calls %llu, bytes %llu, truncations %llu, cycles %llu\n", (*stats)->name, (*stats)->calls, (*stats)->bytes, (*stats)->truncations, (*stats)->cycles);
+}
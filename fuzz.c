@@ -0,0 +1,65 @@
+// fuzz target for the tokenizer, preprocessor and generator.
+//
+// libfuzzer:
+//     clang -g -O1 -fsanitize=fuzzer,address,undefined fuzz.c spg.c -o build/fuzz
+//     build/fuzz corpus examples
+// afl or to reproduce a crash, build without libfuzzer:
+//     clang -g -fsanitize=address,undefined -DSPG_FUZZ_MAIN fuzz.c spg.c -o build/fuzz
+//     build/fuzz crash-file ...
+//
+// inputs are the content of a file, if the first byte is below 8 it
+// selects the options instead (1 --compact, 2 --instrument, 4 --preprocess)
+// so the headers in examples can be used as they are.
+#include <stdint.h> // uint8_t
+#include <stdio.h>  // fopen, fread, fclose, fprintf
+#include "spg.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    struct spg_context *context = spg_context_create();
+    if (!context)
+        return 0;
+    int options = spg_option_no_includes;
+    if (size && data[0] < 8) {
+        if (data[0] & 1)
+            options |= spg_option_compact;
+        if (data[0] & 2)
+            options |= spg_option_instrument;
+        if (data[0] & 4)
+            options |= spg_option_preprocess;
+        data++;
+        size--;
+    }
+    spg_set_options(context, options);
+    // the generated code is only measured, not written.
+    spg_add_buffer(context, "fuzz.h", (const char *) data, size);
+    spg_generate(context, 0);
+    // again, with the typedefs found by the first call.
+    spg_add_buffer(context, "fuzz2.h", (const char *) data, size);
+    spg_generate(context, 0);
+    spg_context_destroy(context);
+    return 0;
+}
+
+#ifdef SPG_FUZZ_MAIN
+// run each file given (or stdin) through the fuzz target.
+int main(int argc, char **argv)
+{
+    static uint8_t data[1 << 20];
+    if (argc <= 1) {
+        size_t size = fread(data, 1, sizeof(data), stdin);
+        return LLVMFuzzerTestOneInput(data, size);
+    }
+    for (int i = 1; i < argc; i++) {
+        FILE *file = fopen(argv[i], "rb");
+        if (!file) {
+            fprintf(stderr, "file: %s was not able to be processed.\n", argv[i]);
+            continue;
+        }
+        size_t size = fread(data, 1, sizeof(data), file);
+        fclose(file);
+        LLVMFuzzerTestOneInput(data, size);
+    }
+    return 0;
+}
+#endif
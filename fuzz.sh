@@ -0,0 +1,7 @@
+#!/bin/bash
+# fuzz the tokenizer, preprocessor and generator with libfuzzer.
+# the corpus starts with the headers in examples, extra arguments
+# are passed to libfuzzer (ie, -max_total_time=60).
+mkdir -p build/corpus
+clang -g -O1 -fsanitize=fuzzer,address,undefined fuzz.c spg.c -o build/fuzz.linux
+build/fuzz.linux -timeout=5 -artifact_prefix=build/ "$@" build/corpus examples
@@ -0,0 +1,2649 @@
+// clock_gettime
+#define _POSIX_C_SOURCE 199309L
+
+#include <assert.h> // assert
+#include <stdarg.h> // va_list, va_start, va_end
+#include <stdlib.h> // malloc, free, size_t
+#include <stdio.h>  // printf, vsnprintf, fopen, fclose, ftell, fseek, SEEK_END, SEEK_SET
+#include <ctype.h>  // isspace, isalpha, isdigit
+#include <string.h> // strncmp, strcmp, strlen, strstr
+#include "spg.h"
+#ifdef _WIN32
+#include <windows.h> // QueryPerformanceCounter, QueryPerformanceFrequency
+#else
+#include <time.h>   // clock_gettime, CLOCK_MONOTONIC
+#endif
+
+enum token_type {
+    token_none,
+    token_pound,
+    token_identifier,
+    token_number,
+    token_open_parenthesis,
+    token_close_parenthesis,
+    token_open_brace,
+    token_close_brace,
+    token_open_brackets,
+    token_close_brackets,
+    token_keyword,
+    token_colon,
+    token_less_than,
+    token_greather_than,
+    token_file_path,
+    token_string,
+    token_star,
+    token_comma,
+    token_unknown,
+    token_eof,
+};
+
+struct token {
+    const char *text;
+    size_t len;
+    enum token_type type;
+    // yes i know this doesn't go here
+    // but it's convenient
+    int is_union;
+    int is_enum;
+};
+
+struct type_alias {
+    struct token parent;
+    struct token alias;
+    // type at the end of the chain and how many typedefs were followed
+    // to get there (more than 64 if it wasn't followed), valid while
+    // aliases_count is resolved_count.
+    struct token resolved;
+    size_t resolved_chain;
+    size_t resolved_count;
+};
+
+enum field_kind {
+    // unsupported types (function pointers, typedef'd unions, ...)
+    // nothing gets printed for these.
+    field_kind_none,
+    field_kind_char,
+    field_kind_int,
+    field_kind_long,
+    field_kind_float,
+    // struct with its own print_type function.
+    field_kind_struct,
+    // struct or union declared inline, its members get printed.
+    field_kind_inline,
+};
+
+// one node of the type tree built for each struct member.
+// int **foo[2][3] ends up as kind int, 2 pointers and 2 dimensions.
+struct field {
+    enum field_kind kind;
+    // resolved type name.
+    struct token type;
+    // empty for anonymous inline structs/unions (c11).
+    struct token name;
+    int is_union;
+    // spg_redact, the value is never printed.
+    int is_redacted;
+    // bit of the field in the mask of print_type_fields (1 = 1ULL << 0)
+    // 0 if the field is always printed.
+    int bit;
+    // long long, long double.
+    int longs;
+    // type as written without qualifiers (unsigned int, custom_type)
+    // empty if it can't be named (anonymous enums)
+    char ctype[64];
+    int pointers;
+    // int foo : 3, it has no address so it can't go in a table.
+    int is_bitfield;
+    // size of each dimension as written in the source (int foo[N][4])
+    struct token dimensions[8];
+    size_t dimensions_count;
+    // members of inline structs and unions.
+    struct field *members;
+    struct field *next;
+};
+
+// counters reported with --stats.
+struct stats {
+    // wall time of each phase in seconds.
+    double read_time;
+    double tokenize_time;
+    double typedef_time;
+    double emit_time;
+    size_t bytes_scanned;
+    size_t tokens;
+    size_t alias_lookups;
+    // longest typedef chain followed (a -> b -> int = 2)
+    size_t alias_max_depth;
+    size_t structs;
+    size_t fields;
+    size_t output_bytes;
+};
+
+struct source {
+    char path[260];
+    char *text;
+    size_t size;
+    // per file --stats.
+    size_t tokens;
+    double typedef_time;
+    double emit_time;
+};
+
+// file or buffer added with spg_add_file/spg_add_buffer,
+// waiting for spg_generate.
+struct input {
+    char path[260];
+    // null if the file couldn't be read.
+    char *text;
+};
+
+// type printed from a table of offsets by a shared function (--compact)
+struct table_type {
+    char ctype[64];
+    const char *format;
+    int is_string;
+};
+
+// #define NAME value
+struct define {
+    char name[64];
+    char value[128];
+};
+
+// #if, #elif, #else block.
+struct condition {
+    int parent_active;
+    int active;
+    // if one of the branches was already active.
+    int taken;
+};
+
+// open addressing index of the names of an array, each slot holds
+// the index + 1 of the first item with the name (0 if empty)
+struct name_index {
+    size_t *slots;
+    size_t capacity;
+    // the last item with a name wins instead of the first.
+    int keep_last;
+};
+
+struct tokenizer {
+    const char *file;
+    const char *cursor;
+    struct token prev;
+    struct token token;
+    struct type_alias *aliases;
+    size_t aliases_count;
+    size_t aliases_capacity;
+    struct name_index alias_index;
+    // type tree of the struct being generated.
+    struct field fields[1024];
+    size_t fields_count;
+    struct token struct_name;
+    // group fields of the same type into tables.
+    int compact;
+    // count calls, bytes, truncations and cycles of each print function.
+    int instrument;
+    // names of the structs generated so far.
+    struct token *generated;
+    size_t generated_count;
+    size_t generated_capacity;
+    struct name_index generated_index;
+    // first struct of the current spg_generate call.
+    size_t first_generated;
+    // spg_generate calls so far, names the stats and spg_print
+    // selections of each one.
+    int generate_calls;
+    // last call that declared structs, 0 if none did.
+    int declared_call;
+    struct input *inputs;
+    size_t inputs_count;
+    size_t inputs_capacity;
+    // files to process, in the order they get processed. they are kept
+    // in memory until the end since aliases point to their content.
+    struct source *sources;
+    size_t sources_count;
+    size_t sources_capacity;
+    // sources by path, the last one with a path wins.
+    struct name_index source_index;
+    // first source of the current spg_generate call.
+    size_t first_source;
+    // follow #include "file" and skip inactive #if blocks.
+    int preprocess;
+    struct define defines[1024];
+    size_t defines_count;
+    // don't read the files of #include (fuzzing).
+    int skip_includes;
+    // nesting of the struct/union being parsed or skipped.
+    int depth;
+    // tokenize the sources an extra time to find out its cost (--stats)
+    int tokenize;
+    // where the code is generated, if null only the size is computed.
+    struct spg_sink *sink;
+    // the code of a print function is held here while it's generated so
+    // the value printers it uses can be emitted before it (--compact)
+    int holding;
+    char *held;
+    size_t held_len;
+    size_t held_capacity;
+    // value printers emitted in the current spg_generate call.
+    struct table_type table_types[64];
+    size_t table_types_count;
+    struct stats stats;
+};
+
+// wall clock time in seconds.
+static double get_time(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER counter = {0};
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+#endif
+}
+
+// room for one more item in an array of count items, moved to a bigger
+// block if it's full. null if there is not enough memory, then items
+// is left as it was.
+static void *grow(void *items, size_t *capacity, size_t count, size_t size)
+{
+    assert(capacity);
+    assert(size);
+    if (count < *capacity)
+        return items;
+    size_t new_capacity = *capacity ? *capacity * 2 : 64;
+    if (new_capacity > (size_t) -1 / size)
+        return 0;
+    void *grown = realloc(items, new_capacity * size);
+    if (grown)
+        *capacity = new_capacity;
+    return grown;
+}
+
+// send generated code to the sink, or hold it.
+static void output(struct tokenizer *tokenizer, const char *text, size_t len)
+{
+    assert(tokenizer);
+    assert(text);
+    if (!tokenizer->sink || !tokenizer->sink->write)
+        return;
+    if (!tokenizer->holding) {
+        tokenizer->sink->write(tokenizer->sink->user, text, len);
+        return;
+    }
+    if (tokenizer->held_len + len > tokenizer->held_capacity) {
+        size_t capacity = tokenizer->held_capacity ? tokenizer->held_capacity * 2 : 4096;
+        while (capacity < tokenizer->held_len + len)
+            capacity *= 2;
+        char *held = realloc(tokenizer->held, capacity);
+        if (!held)
+            return;
+        tokenizer->held = held;
+        tokenizer->held_capacity = capacity;
+    }
+    memcpy(tokenizer->held + tokenizer->held_len, text, len);
+    tokenizer->held_len += len;
+}
+
+// write generated code.
+static void emit(struct tokenizer *tokenizer, const char *format, ...)
+{
+    assert(tokenizer);
+    assert(format);
+    char buffer[1024] = {0};
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (written <= 0)
+        return;
+    tokenizer->stats.output_bytes += written;
+    if (!tokenizer->sink || !tokenizer->sink->write)
+        return;
+    if ((size_t) written < sizeof(buffer)) {
+        output(tokenizer, buffer, written);
+        return;
+    }
+    // long names, only happens with weird input.
+    char *text = malloc(written + 1);
+    if (!text)
+        return;
+    va_start(args, format);
+    vsnprintf(text, written + 1, format, args);
+    va_end(args);
+    output(tokenizer, text, written);
+    free(text);
+}
+
+static char *read_file(const char *file_path)
+{
+    assert(file_path);
+    FILE *file = fopen(file_path, "r");
+    if (!file)
+        return 0;
+    size_t prev = ftell(file);
+    fseek(file, 0, SEEK_END);
+    size_t size = ftell(file);
+    fseek(file, prev, SEEK_SET);
+    char *result = malloc(size + 1);
+    if (!result) {
+        fclose(file);
+        return 0;
+    }
+    // in text mode less bytes may be read (\r\n -> \n)
+    size = fread(result, 1, size, file);
+    // null terminator
+    result[size] = 0;
+    fclose(file);
+    return result;
+}
+
+static const char *skip_whitespace(const char *src)
+{
+    assert(src);
+    while (*src) {
+        if (isspace((unsigned char) *src)) {
+            src++;
+            continue;
+        }
+        // skip // comments
+        if (*src == '/' && *(src + 1) == '/') {
+            src++;
+            src++;
+            while (*src && *src != '\n')
+                src++;
+            continue;
+        }
+        // skip /* comments
+        if (*src == '/' && *(src + 1) == '*') {
+            src++;
+            src++;
+            // search end of comment
+            while (*src && !(*src == '*' && *(src + 1) == '/'))
+                src++;
+            if (*src == '*' && *(src + 1) == '/') {
+                src++;
+                src++;
+            }
+            continue;
+        }
+        break;
+    }
+    return src;
+}
+
+// just for debug.
+static void print_token(struct token token)
+{
+    printf(
+        "token (len: %d, type: %d): '%.*s'\n",
+        token.len,
+        token.type,
+        token.len,
+        token.text
+    );
+}
+
+static struct token get_token(const char *src)
+{
+    assert(src);
+    src = skip_whitespace(src);
+
+    struct token token = {0};
+    token.text = src;
+    token.len = 1;
+
+    switch (*src) {
+    case 0:
+    case EOF:
+        token.len = 0;
+        token.type = token_eof;
+        break;
+    case '[':
+        token.type = token_open_brackets;
+        break;
+    case ']':
+        token.type = token_close_brackets;
+        break;
+    case '*':
+        token.type = token_star;
+        break;
+    case ',':
+        token.type = token_comma;
+        break;
+    case '<':
+        token.type = token_less_than;
+        break;
+    case '>':
+        token.type = token_greather_than;
+        break;
+    case '#':
+        token.type = token_pound;
+        break;
+    case '{':
+        token.type = token_open_brace;
+        break;
+    case '}':
+        token.type = token_close_brace;
+        break;
+    case '(':
+        token.type = token_open_parenthesis;
+        break;
+    case ')':
+        token.type = token_close_parenthesis;
+        break;
+    case ';':
+        token.type = token_colon;
+        break;
+    case '"': {
+        const char *start = src;
+        token.type = token_string;
+        src++;
+        while (*src && *src != '"')
+            src++;
+        // unterminated strings end with the file.
+        if (*src)
+            src++;
+        token.len = src - start;
+    } break;
+    default: {
+        const char *start = src;
+        if (isdigit((unsigned char) *src)) {
+            token.type = token_number;
+            do {
+                src++;
+                if (*src == '.' || *src == 'f')
+                    src++;
+            } while (isdigit((unsigned char) *src));
+        } else if (isalpha((unsigned char) *src)) {
+            token.type = token_identifier;
+            do {
+                src++;
+                if (*src == '_')
+                    src++;
+                // this is not really required but...
+                if (*src == '.') {
+                    token.type = token_file_path;
+                    src++;
+                }
+                // identifiers can contain digits in their names.
+                while (isdigit((unsigned char) *src))
+                    src++;
+            } while (isalpha((unsigned char) *src));
+        } else {
+            src++;
+            token.type = token_unknown;
+        }
+        token.len = src - start;
+    } break;
+    }
+    return token;
+}
+
+// append formatted text to the end of the (null terminated) dest buffer.
+static void append(char *dest, size_t n, const char *format, ...)
+{
+    assert(dest);
+    assert(format);
+    size_t len = strlen(dest);
+    if (len + 1 >= n)
+        return;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(dest + len, n - len, format, args);
+    va_end(args);
+}
+
+static int token_matches(struct token token, const char *match)
+{
+    assert(match);
+    size_t match_len = 0;
+    for (size_t i = 0; i < token.len; i++) {
+        if (token.text[i] != *match)
+            return 0;
+        match++;
+        match_len++;
+    }
+    return match_len == token.len && *match == 0;
+}
+
+static void consume_token(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    assert(tokenizer->file);
+    if (!tokenizer->cursor)
+        tokenizer->cursor = tokenizer->file;
+    if (tokenizer->token.type == token_eof)
+        return;
+    tokenizer->prev = tokenizer->token;
+    tokenizer->token = get_token(tokenizer->cursor);
+    tokenizer->cursor = tokenizer->token.text + tokenizer->token.len;
+}
+
+static void revert_to_prev_token(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    assert(tokenizer->cursor);
+    tokenizer->cursor = tokenizer->prev.text;
+    // prev is wrong but i don't think we really need it
+    // when reverting
+    // tokenizer->prev = tokenizer->token;
+    tokenizer->token = get_token(tokenizer->cursor);
+    tokenizer->cursor = tokenizer->token.text + tokenizer->token.len;
+}
+
+// static struct token peek_token(struct tokenizer *tokenizer)
+// {
+//     assert(tokenizer);
+//     assert(tokenizer->cursor);
+//     return get_token(tokenizer->cursor);
+// }
+
+static int consume_token_type(struct tokenizer *tokenizer, enum token_type type)
+{
+    assert(tokenizer);
+    if (tokenizer->token.type == type) {
+        consume_token(tokenizer);
+        return 1;
+    }
+    return 0;
+}
+
+static int consume_keyword(struct tokenizer *tokenizer, const char *keyword)
+{
+    assert(tokenizer);
+    if (tokenizer->token.type == token_identifier && token_matches(tokenizer->token, keyword)) {
+        consume_token(tokenizer);
+        return 1;
+    }
+    return 0;
+}
+
+// fnv-1a
+static size_t hash_text(const char *text, size_t len)
+{
+    assert(text || !len);
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char) text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int is_same_name(struct token a, struct token b)
+{
+    return a.len == b.len && strncmp(a.text, b.text, a.len) == 0;
+}
+
+// index + 1 of the first item named name, 0 if there is none. name_of
+// gives the name of an item of the array.
+static size_t find_name(struct tokenizer *tokenizer, struct name_index *index, struct token (*name_of)(struct tokenizer *, size_t), struct token name)
+{
+    assert(tokenizer);
+    assert(index);
+    assert(name_of);
+    if (!index->capacity)
+        return 0;
+    size_t mask = index->capacity - 1;
+    for (size_t slot = hash_text(name.text, name.len) & mask; index->slots[slot]; slot = (slot + 1) & mask) {
+        if (is_same_name(name_of(tokenizer, index->slots[slot] - 1), name))
+            return index->slots[slot];
+    }
+    return 0;
+}
+
+// put item in its slot. if one with the same name is there already,
+// the first one wins unless keep_last is set.
+static void put_name(struct tokenizer *tokenizer, struct name_index *index, struct token (*name_of)(struct tokenizer *, size_t), size_t item)
+{
+    assert(tokenizer);
+    assert(index);
+    assert(name_of);
+    struct token name = name_of(tokenizer, item);
+    size_t mask = index->capacity - 1;
+    size_t slot = hash_text(name.text, name.len) & mask;
+    for (; index->slots[slot]; slot = (slot + 1) & mask) {
+        if (is_same_name(name_of(tokenizer, index->slots[slot] - 1), name))
+            break;
+    }
+    if (!index->slots[slot] || index->keep_last)
+        index->slots[slot] = item + 1;
+}
+
+// add the last of count items to the index. returns 0 if there is not
+// enough memory.
+static int index_name(struct tokenizer *tokenizer, struct name_index *index, struct token (*name_of)(struct tokenizer *, size_t), size_t count)
+{
+    assert(tokenizer);
+    assert(index);
+    assert(count);
+    // keep it at most half full, rebuilt from every item when it grows.
+    if (count * 2 > index->capacity) {
+        size_t capacity = index->capacity ? index->capacity * 2 : 256;
+        size_t *slots = calloc(capacity, sizeof(*slots));
+        if (!slots)
+            return 0;
+        free(index->slots);
+        index->slots = slots;
+        index->capacity = capacity;
+        for (size_t i = 0; i + 1 < count; i++)
+            put_name(tokenizer, index, name_of, i);
+    }
+    put_name(tokenizer, index, name_of, count - 1);
+    return 1;
+}
+
+static struct token alias_name(struct tokenizer *tokenizer, size_t index)
+{
+    assert(tokenizer);
+    return tokenizer->aliases[index].alias;
+}
+
+static struct type_alias *find_alias(struct tokenizer *tokenizer, struct token name)
+{
+    assert(tokenizer);
+    size_t found = find_name(tokenizer, &tokenizer->alias_index, alias_name, name);
+    return found ? &tokenizer->aliases[found - 1] : 0;
+}
+
+// follow the typedefs of alias. chains longer than 64 (or that loop,
+// typedef a b; typedef b a;) are not followed. the result is kept in
+// the typedef of alias, so the next lookups stop at the first typedef
+// already resolved.
+static struct token get_original_type(struct tokenizer *tokenizer, struct token alias)
+{
+    assert(tokenizer);
+    tokenizer->stats.alias_lookups++;
+    struct type_alias *first = find_alias(tokenizer, alias);
+    if (!first || first->parent.type == token_none)
+        return alias;
+    if (first->resolved_count == tokenizer->aliases_count)
+        return first->resolved;
+    struct token type = alias;
+    size_t chain = 0;
+    while (chain <= 64) {
+        struct type_alias *found = find_alias(tokenizer, type);
+        if (!found || found->parent.type == token_none)
+            break;
+        if (found->resolved_count == tokenizer->aliases_count) {
+            type = found->resolved;
+            chain += found->resolved_chain;
+            break;
+        }
+        type = found->parent;
+        chain++;
+    }
+    if (chain > 64)
+        type = alias;
+    else if (chain > tokenizer->stats.alias_max_depth)
+        tokenizer->stats.alias_max_depth = chain;
+    first->resolved = type;
+    first->resolved_chain = chain;
+    first->resolved_count = tokenizer->aliases_count;
+    return type;
+}
+
+static void skip_union(struct tokenizer *tokenizer);
+
+// skip until the brace closing the current block, which isn't consumed.
+static void skip_body(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    size_t braces = 0;
+    while (tokenizer->token.type != token_eof) {
+        if (tokenizer->token.type == token_close_brace) {
+            if (!braces)
+                break;
+            braces--;
+        }
+        if (tokenizer->token.type == token_open_brace)
+            braces++;
+        consume_token(tokenizer);
+    }
+}
+
+static void skip_struct_property(struct tokenizer *tokenizer)
+{
+    // type
+    if (tokenizer->token.type != token_identifier)
+        return;
+    if (token_matches(tokenizer->token, "union"))
+        return;
+    if (token_matches(tokenizer->token, "struct"))
+        return;
+    if (token_matches(tokenizer->token, "union"))
+        return;
+    while (tokenizer->token.type != token_colon && tokenizer->token.type != token_eof)
+        consume_token(tokenizer);
+    // consume ;
+    consume_token_type(tokenizer, token_colon);
+}
+
+static void skip_enum(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    if (!consume_keyword(tokenizer, "enum"))
+        return;
+    // consume name
+    consume_token_type(tokenizer, token_identifier);
+    // {
+    if (!consume_token_type(tokenizer, token_open_brace))
+        return;
+    while (tokenizer->token.type != token_close_brace && tokenizer->token.type != token_eof)
+        consume_token(tokenizer);
+    // }
+    consume_token_type(tokenizer, token_close_brace);
+    // consume ;
+    consume_token_type(tokenizer, token_colon);
+}
+
+static void skip_struct(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    if (!consume_keyword(tokenizer, "struct"))
+        return;
+    // consume name
+    consume_token_type(tokenizer, token_identifier);
+    // {
+    if (!consume_token_type(tokenizer, token_open_brace))
+        return;
+    // too deep, skip it without recursion.
+    if (tokenizer->depth >= 64)
+        skip_body(tokenizer);
+    tokenizer->depth++;
+    while (tokenizer->token.type != token_close_brace && tokenizer->token.type != token_eof) {
+        const char *start = tokenizer->token.text;
+        skip_union(tokenizer);
+        skip_struct(tokenizer);
+        skip_enum(tokenizer);
+        skip_struct_property(tokenizer);
+        // make sure we always move forward on unexpected tokens.
+        if (tokenizer->token.text == start)
+            consume_token(tokenizer);
+    }
+    tokenizer->depth--;
+    // }
+    consume_token_type(tokenizer, token_close_brace);
+    // consume property name
+    // consume_token_type(tokenizer, token_identifier);
+    // consume ;
+    consume_token_type(tokenizer, token_colon);
+}
+
+static void skip_union(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    if (!consume_keyword(tokenizer, "union"))
+        return;
+    // consume name
+    consume_token_type(tokenizer, token_identifier);
+    // {
+    if (!consume_token_type(tokenizer, token_open_brace))
+        return;
+    // too deep, skip it without recursion.
+    if (tokenizer->depth >= 64)
+        skip_body(tokenizer);
+    tokenizer->depth++;
+    while (tokenizer->token.type != token_close_brace && tokenizer->token.type != token_eof) {
+        const char *start = tokenizer->token.text;
+        // consume_token(tokenizer);
+        int is_union = token_matches(tokenizer->token, "union");
+        int is_struct = token_matches(tokenizer->token, "struct");
+        int is_enum = token_matches(tokenizer->token, "enum");
+        if (is_union || is_struct ||is_enum) {
+            skip_union(tokenizer);
+            skip_struct(tokenizer);
+            skip_enum(tokenizer);
+            // skip property's name
+            consume_token_type(tokenizer, token_identifier);
+            // ;
+            consume_token_type(tokenizer, token_colon);
+        }
+        skip_struct_property(tokenizer);
+        // make sure we always move forward on unexpected tokens.
+        if (tokenizer->token.text == start)
+            consume_token(tokenizer);
+    }
+    tokenizer->depth--;
+    // }
+    consume_token_type(tokenizer, token_close_brace);
+    // consume property name
+    // consume_token_type(tokenizer, token_identifier);
+    // consume ;
+    consume_token_type(tokenizer, token_colon);
+}
+
+// structs that get a print function, found before generating
+// them so their functions can be declared first.
+static struct token generated_name(struct tokenizer *tokenizer, size_t index)
+{
+    assert(tokenizer);
+    return tokenizer->generated[index];
+}
+
+static void add_generated(struct tokenizer *tokenizer, struct token name)
+{
+    assert(tokenizer);
+    if (name.type != token_identifier)
+        return;
+    struct token *generated = grow(tokenizer->generated, &tokenizer->generated_capacity, tokenizer->generated_count, sizeof(*generated));
+    if (generated) {
+        tokenizer->generated = generated;
+        tokenizer->generated[tokenizer->generated_count] = name;
+        tokenizer->generated_count++;
+        if (index_name(tokenizer, &tokenizer->generated_index, generated_name, tokenizer->generated_count))
+            return;
+        tokenizer->generated_count--;
+    }
+    // without it the code of nested members wouldn't compile.
+    emit(tokenizer, "#error \"not enough memory to generate struct %.*s\"\n", (int) name.len, name.text);
+}
+
+// generate_properties struct name
+static void parse_generated(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    if (!consume_keyword(tokenizer, "generate_properties"))
+        return;
+    if (!consume_keyword(tokenizer, "struct"))
+        return;
+    add_generated(tokenizer, tokenizer->token);
+}
+
+static void parse_typedef(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    if (!consume_keyword(tokenizer, "typedef"))
+        return;
+    // generate_properties for inline structs
+    int is_generated = consume_keyword(tokenizer, "generate_properties");
+    // union or struct
+    int is_union = consume_keyword(tokenizer, "union");
+    int is_struct = consume_keyword(tokenizer, "struct");
+    int is_enum = consume_keyword(tokenizer, "enum");
+    if (is_generated && is_struct)
+        add_generated(tokenizer, tokenizer->token);
+    struct type_alias *aliases = grow(tokenizer->aliases, &tokenizer->aliases_capacity, tokenizer->aliases_count, sizeof(*aliases));
+    if (!aliases) {
+        // members of the type would be left out without notice.
+        emit(tokenizer, "#error \"not enough memory to keep the typedefs\"\n");
+        return;
+    }
+    tokenizer->aliases = aliases;
+    tokenizer->aliases[tokenizer->aliases_count] = (struct type_alias) {0};
+    // todo: check if the struct has a name or if it's anon
+    tokenizer->aliases[tokenizer->aliases_count].parent = tokenizer->token;
+    tokenizer->aliases[tokenizer->aliases_count].parent.is_union = is_union;
+    tokenizer->aliases[tokenizer->aliases_count].parent.is_enum = is_enum;    
+    if (is_union || is_struct || is_enum) {
+        revert_to_prev_token(tokenizer);
+        skip_struct(tokenizer);
+        skip_union(tokenizer);
+        skip_enum(tokenizer);
+    } else {
+        // consume type
+        consume_token_type(tokenizer, token_identifier);
+    }
+    // if (tokenizer->aliases[tokenizer->aliases_count].parent.type != token_identifier) {
+    //     tokenizer->aliases[tokenizer->aliases_count].parent.text = tokenizer->token.text;
+    //     tokenizer->aliases[tokenizer->aliases_count].parent.len = tokenizer->token.len;
+    // }
+    tokenizer->aliases[tokenizer->aliases_count].alias = tokenizer->token;
+    tokenizer->aliases_count++;
+    if (!index_name(tokenizer, &tokenizer->alias_index, alias_name, tokenizer->aliases_count)) {
+        tokenizer->aliases_count--;
+        emit(tokenizer, "#error \"not enough memory to keep the typedefs\"\n");
+        return;
+    }
+    // typedef name
+    consume_token_type(tokenizer, token_identifier);
+    // ;
+    // consume_token_type(tokenizer, token_colon);
+}
+
+static struct field *new_field(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    if (tokenizer->fields_count >= sizeof(tokenizer->fields) / sizeof(*tokenizer->fields))
+        return 0;
+    struct field *field = &tokenizer->fields[tokenizer->fields_count];
+    tokenizer->fields_count++;
+    *field = (struct field) {0};
+    return field;
+}
+
+static struct field *parse_members(struct tokenizer *tokenizer);
+
+static void add_ctype(struct field *field, struct token token)
+{
+    assert(field);
+    append(field->ctype, sizeof(field->ctype), "%s%.*s", field->ctype[0] ? " " : "", (int) token.len, token.text);
+}
+
+// parse the type of a member, ie, const unsigned int, struct foo,
+// custom_type or an inline struct { ... } / union { ... }
+static void parse_type(struct tokenizer *tokenizer, struct field *field)
+{
+    assert(tokenizer);
+    assert(field);
+    int has_type = 0;
+    int is_char = 0;
+    int is_int = 0;
+    int is_float = 0;
+    while (tokenizer->token.type == token_identifier) {
+        if (consume_keyword(tokenizer, "const") ||
+            consume_keyword(tokenizer, "volatile") ||
+            consume_keyword(tokenizer, "static"))
+            continue;
+        if (consume_keyword(tokenizer, "char")) {
+            add_ctype(field, tokenizer->prev);
+            has_type = is_char = 1;
+            continue;
+        }
+        if (consume_keyword(tokenizer, "int") ||
+            consume_keyword(tokenizer, "short") ||
+            consume_keyword(tokenizer, "signed") ||
+            consume_keyword(tokenizer, "unsigned")) {
+            add_ctype(field, tokenizer->prev);
+            has_type = is_int = 1;
+            continue;
+        }
+        if (consume_keyword(tokenizer, "long")) {
+            add_ctype(field, tokenizer->prev);
+            has_type = 1;
+            field->longs++;
+            continue;
+        }
+        if (consume_keyword(tokenizer, "float") || consume_keyword(tokenizer, "double")) {
+            add_ctype(field, tokenizer->prev);
+            has_type = is_float = 1;
+            continue;
+        }
+        int is_struct = consume_keyword(tokenizer, "struct");
+        int is_union = consume_keyword(tokenizer, "union");
+        int is_enum = consume_keyword(tokenizer, "enum");
+        if (is_struct || is_union || is_enum) {
+            struct token keyword = tokenizer->prev;
+            // tag name, optional for inline declarations.
+            field->type = tokenizer->token;
+            if (consume_token_type(tokenizer, token_identifier)) {
+                add_ctype(field, keyword);
+                add_ctype(field, field->type);
+            }
+            if (is_enum) {
+                field->kind = field_kind_int;
+                if (consume_token_type(tokenizer, token_open_brace)) {
+                    while (tokenizer->token.type != token_close_brace && tokenizer->token.type != token_eof)
+                        consume_token(tokenizer);
+                    consume_token_type(tokenizer, token_close_brace);
+                }
+            } else if (consume_token_type(tokenizer, token_open_brace)) {
+                field->kind = field_kind_inline;
+                field->is_union = is_union;
+                // too deep, skip it without recursion.
+                if (tokenizer->depth >= 64) {
+                    field->kind = field_kind_none;
+                    skip_body(tokenizer);
+                } else {
+                    tokenizer->depth++;
+                    field->members = parse_members(tokenizer);
+                    tokenizer->depth--;
+                }
+                consume_token_type(tokenizer, token_close_brace);
+            } else if (is_struct) {
+                field->kind = field_kind_struct;
+            }
+            return;
+        }
+        // the type is already known, this must be the member's name.
+        if (has_type)
+            break;
+        add_ctype(field, tokenizer->token);
+        struct token type = get_original_type(tokenizer, tokenizer->token);
+        consume_token_type(tokenizer, token_identifier);
+        has_type = 1;
+        field->type = type;
+        if (type.is_enum)
+            is_int = 1;
+        else if (type.is_union || type.type != token_identifier)
+            return;
+        else if (token_matches(type, "char"))
+            is_char = 1;
+        else if (token_matches(type, "int") || token_matches(type, "short") ||
+                 token_matches(type, "signed") || token_matches(type, "unsigned"))
+            is_int = 1;
+        else if (token_matches(type, "size_t") || token_matches(type, "long"))
+            field->longs++;
+        else if (token_matches(type, "float") || token_matches(type, "double"))
+            is_float = 1;
+        else
+            field->kind = field_kind_struct;
+    }
+    if (field->kind != field_kind_none)
+        return;
+    if (is_char)
+        field->kind = field_kind_char;
+    else if (is_float)
+        field->kind = field_kind_float;
+    else if (field->longs)
+        field->kind = field_kind_long;
+    else if (is_int)
+        field->kind = field_kind_int;
+}
+
+// parse a member declaration and its declarators, ie
+// int a, *b, c[4][4];
+// new fields are appended to the list first - last.
+static void parse_declaration(struct tokenizer *tokenizer, struct field **first, struct field **last)
+{
+    assert(tokenizer);
+    assert(first);
+    assert(last);
+    struct field type = {0};
+    // annotations
+    int is_skipped = 0;
+    for (;;) {
+        if (consume_keyword(tokenizer, "spg_skip"))
+            is_skipped = 1;
+        else if (consume_keyword(tokenizer, "spg_redact"))
+            type.is_redacted = 1;
+        else
+            break;
+    }
+    parse_type(tokenizer, &type);
+    if (is_skipped)
+        type.kind = field_kind_none;
+    // anonymous inline struct/union, its members are accessed directly.
+    int is_anonymous = type.kind == field_kind_inline && tokenizer->token.type == token_colon;
+    do {
+        struct field *field = new_field(tokenizer);
+        if (!field)
+            break;
+        *field = type;
+        while (consume_token_type(tokenizer, token_star)) {
+            field->pointers++;
+            consume_keyword(tokenizer, "const");
+        }
+        // function pointers are not supported.
+        if (tokenizer->token.type == token_open_parenthesis)
+            field->kind = field_kind_none;
+        // or pointers of pointers of pointers...
+        if (field->pointers > 8)
+            field->kind = field_kind_none;
+        if (!is_anonymous) {
+            field->name = tokenizer->token;
+            if (!consume_token_type(tokenizer, token_identifier))
+                field->kind = field_kind_none;
+        }
+        // arrays
+        while (consume_token_type(tokenizer, token_open_brackets)) {
+            struct token size = tokenizer->token;
+            while (tokenizer->token.type != token_close_brackets &&
+                   tokenizer->token.type != token_colon &&
+                   tokenizer->token.type != token_eof)
+                consume_token(tokenizer);
+            size.len = 0;
+            if (tokenizer->token.text != size.text)
+                size.len = (tokenizer->prev.text + tokenizer->prev.len) - size.text;
+            consume_token_type(tokenizer, token_close_brackets);
+            size_t max_dimensions = sizeof(field->dimensions) / sizeof(*field->dimensions);
+            // flexible array members have no size to iterate.
+            if (!size.len || field->dimensions_count >= max_dimensions) {
+                field->kind = field_kind_none;
+                continue;
+            }
+            field->dimensions[field->dimensions_count] = size;
+            field->dimensions_count++;
+        }
+        // skip bit fields, function pointer parameters, etc.
+        int parenthesis = 0;
+        while (tokenizer->token.type != token_eof) {
+            if (tokenizer->token.type == token_open_parenthesis)
+                parenthesis++;
+            if (tokenizer->token.type == token_close_parenthesis)
+                parenthesis--;
+            if (parenthesis <= 0 &&
+                (tokenizer->token.type == token_comma ||
+                 tokenizer->token.type == token_colon ||
+                 tokenizer->token.type == token_close_brace))
+                break;
+            if (!parenthesis && tokenizer->token.len == 1 && *tokenizer->token.text == ':')
+                field->is_bitfield = 1;
+            consume_token(tokenizer);
+        }
+        if (*last)
+            (*last)->next = field;
+        else
+            *first = field;
+        *last = field;
+    } while (consume_token_type(tokenizer, token_comma));
+    // ;
+    consume_token_type(tokenizer, token_colon);
+}
+
+// parse members until the closing brace, which isn't consumed.
+static struct field *parse_members(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    struct field *first = 0;
+    struct field *last = 0;
+    while (tokenizer->token.type != token_close_brace && tokenizer->token.type != token_eof) {
+        const char *start = tokenizer->token.text;
+        parse_declaration(tokenizer, &first, &last);
+        // make sure we always move forward on unexpected tokens.
+        if (tokenizer->token.text == start)
+            consume_token(tokenizer);
+    }
+    return first;
+}
+
+static const char *stars(int count)
+{
+    static const char *all = "********";
+    assert(count >= 0 && count <= 8);
+    return all + 8 - count;
+}
+
+// printf format of char, int, long and float fields.
+static char *field_format(struct field *field)
+{
+    assert(field);
+    if (field->kind == field_kind_char)
+        return "%c";
+    if (field->kind == field_kind_int)
+        return "%d";
+    if (field->kind == field_kind_long)
+        return field->longs > 1 ? "%lld" : "%ld";
+    if (field->kind == field_kind_float)
+        return field->longs ? "%Lf" : "%f";
+    return "";
+}
+
+static void generate_fields(struct tokenizer *tokenizer, struct field *fields, const char *access, const char *label, int in_union, int loops);
+
+// add what was just printed.
+static void generate_advance(struct tokenizer *tokenizer, const char *identation)
+{
+    assert(tokenizer);
+    assert(identation);
+    emit(tokenizer, "%sif (tmp > 0) written += tmp;\n", identation);
+}
+
+// stop before printing something else once dest is full (only the null
+// terminator fits), unless the required size is being measured. written
+// is raised to n since the print is truncated even if what was written
+// ends right at n - 1.
+static void generate_stop(struct tokenizer *tokenizer, const char *identation)
+{
+    assert(tokenizer);
+    assert(identation);
+    emit(tokenizer, "%sif (written >= n - 1 && !required) { written = n; goto done; }\n", identation);
+}
+
+// access is how the field gets accessed (src->, src->foo.)
+// label is the prefix used when printing the name (foo.)
+// loops is the amount of loops we are in, used to name the indexes.
+
+static void generate_field(struct tokenizer *tokenizer, struct field *field, const char *access, const char *label, int in_union, int loops)
+{
+    assert(tokenizer);
+    assert(field);
+    assert(access);
+    assert(label);
+    char *identation = "    ";
+    if (field->kind == field_kind_none)
+        return;
+    tokenizer->stats.fields++;
+    // fixed size strings, the last dimension holds the characters.
+    int is_fixed_string = field->kind == field_kind_char && !field->pointers && field->dimensions_count;
+    // pointers inside unions may not be the active member, so
+    // instead of following them, print the address.
+    int is_address = in_union && field->pointers;
+    char expr[256] = {0};
+    append(expr, sizeof(expr), "%s%.*s", access, (int) field->name.len, field->name.text);
+    char name[256] = {0};
+    append(name, sizeof(name), "%s%.*s", label, (int) field->name.len, field->name.text);
+    // only print the field if it was selected in the mask.
+    if (field->bit)
+        emit(tokenizer, "%sif (mask & (1ULL << %d))\n", identation, field->bit - 1);
+    if (field->is_redacted) {
+        emit(tokenizer, "%s{\n", identation);
+        generate_stop(tokenizer, identation);
+        emit(tokenizer, "%stmp = snprintf(spg_at(dest, n, written), spg_left(n, written), \"%s: [redacted]\\n\");\n", identation, name);
+        generate_advance(tokenizer, identation);
+        emit(tokenizer, "%s}\n", identation);
+        return;
+    }
+    // arrays
+    size_t dimensions = field->dimensions_count - (is_fixed_string ? 1 : 0);
+    for (size_t i = 0; i < dimensions; i++) {
+        struct token size = field->dimensions[i];
+        // wrap expressions such as N + 1
+        int is_expression = get_token(size.text).len != size.len;
+        emit(
+            tokenizer,
+            "%sfor (size_t i%d = 0; i%d < %s%.*s%s; i%d++)\n",
+            identation,
+            loops,
+            loops,
+            is_expression ? "(" : "",
+            (int) size.len,
+            size.text,
+            is_expression ? ")" : "",
+            loops
+        );
+        append(expr, sizeof(expr), "[i%d]", loops);
+        loops++;
+    }
+    // check for null pointers (foo && *foo && **foo)
+    int checks = is_address ? 0 : field->pointers;
+    char null_check[1024] = {0};
+    for (int i = 0; i < checks; i++)
+        append(null_check, sizeof(null_check), "%s%s%s", i ? " && " : "", stars(i), expr);
+    // inline struct/union, print each member.
+    if (field->kind == field_kind_inline && !is_address) {
+        char member_access[256] = {0};
+        char member_label[256] = {0};
+        if (!field->name.len) {
+            append(member_access, sizeof(member_access), "%s", access);
+            append(member_label, sizeof(member_label), "%s", label);
+        } else if (field->pointers == 1) {
+            append(member_access, sizeof(member_access), "%s->", expr);
+            append(member_label, sizeof(member_label), "%s.", name);
+        } else if (field->pointers) {
+            append(member_access, sizeof(member_access), "(%s%s).", stars(field->pointers), expr);
+            append(member_label, sizeof(member_label), "%s.", name);
+        } else {
+            append(member_access, sizeof(member_access), "%s.", expr);
+            append(member_label, sizeof(member_label), "%s.", name);
+        }
+        in_union = in_union || field->is_union;
+        if (!checks && !dimensions && !field->bit) {
+            generate_fields(tokenizer, field->members, member_access, member_label, in_union, loops);
+            return;
+        }
+        emit(tokenizer, "%s{\n", identation);
+        if (checks) {
+            emit(tokenizer, "%sif (%s)\n", identation, null_check);
+            emit(tokenizer, "%s{\n", identation);
+        }
+        generate_fields(tokenizer, field->members, member_access, member_label, in_union, loops);
+        if (checks) {
+            emit(tokenizer, "%s}\n", identation);
+            emit(tokenizer, "%selse\n", identation);
+            emit(tokenizer, "%s{\n", identation);
+            generate_stop(tokenizer, identation);
+            emit(tokenizer, "%stmp = snprintf(spg_at(dest, n, written), spg_left(n, written), \"%s: NULL\\n\");\n", identation, name);
+            generate_advance(tokenizer, identation);
+            emit(tokenizer, "%s}\n", identation);
+        }
+        emit(tokenizer, "%s}\n", identation);
+        return;
+    }
+    emit(tokenizer, "%s{\n", identation);
+    generate_stop(tokenizer, identation);
+    emit(tokenizer, "%stmp = 0;\n", identation);
+    if (checks)
+        emit(tokenizer, "%sif (%s)\n", identation, null_check);
+    // if no c type was found, then try calling a "print_type" function
+    if (field->kind == field_kind_struct && !is_address) {
+        if (checks)
+            emit(tokenizer, "%s{\n", identation);
+        emit(tokenizer, "%stmp = snprintf(spg_at(dest, n, written), spg_left(n, written), \"%s.\");\n", identation, name);
+        generate_advance(tokenizer, identation);
+        generate_stop(tokenizer, identation);
+        const char *pointer = checks ? stars(field->pointers - 1) : "&";
+        if (find_name(tokenizer, &tokenizer->generated_index, generated_name, field->type)) {
+            // spg_print picks the function from the type of the
+            // field so typedef'd names don't need to be resolved.
+            // when measuring, the size it needs is added even if it
+            // didn't fit, otherwise just what it wrote.
+            emit(tokenizer, "%sif (required)\n", identation);
+            emit(
+                tokenizer,
+                "%s%sspg_print_fields_required(spg_at(dest, n, written), spg_left(n, written), %s%s, ~0ULL, &tmp);\n",
+                identation,
+                identation,
+                pointer,
+                expr
+            );
+            emit(tokenizer, "%selse\n", identation);
+            emit(
+                tokenizer,
+                "%s%stmp = spg_print(spg_at(dest, n, written), spg_left(n, written), %s%s);\n",
+                identation,
+                identation,
+                pointer,
+                expr
+            );
+        } else {
+            // other structs need a print_type function written by hand,
+            // which only gives what it wrote.
+            emit(
+                tokenizer,
+                "%stmp = print_%.*s(spg_at(dest, n, written), spg_left(n, written), %s%s);\n",
+                identation,
+                (int) field->type.len,
+                field->type.text,
+                pointer,
+                expr
+            );
+        }
+        if (checks)
+            emit(tokenizer, "%s}\n", identation);
+    } else {
+        char *format = "";
+        char value[512] = {0};
+        if (is_address) {
+            format = "%p";
+            append(value, sizeof(value), "(void *) %s", expr);
+        } else if (is_fixed_string) {
+            // fixed size strings may not be null terminated.
+            format = "%.*s";
+            append(value, sizeof(value), "(int) sizeof(%s), %s", expr, expr);
+        } else if (field->kind == field_kind_char && field->pointers) {
+            format = "%s";
+            append(value, sizeof(value), "%s%s", stars(field->pointers - 1), expr);
+        } else {
+            format = field_format(field);
+            append(value, sizeof(value), "%s%s", stars(field->pointers), expr);
+        }
+        emit(
+            tokenizer,
+            "%s%stmp = snprintf(spg_at(dest, n, written), spg_left(n, written), \"%s: %s\\n\", %s);\n",
+            identation,
+            checks ? identation : "",
+            name,
+            format,
+            value
+        );
+    }
+    if (checks) {
+        emit(tokenizer, "%selse\n", identation);
+        emit(tokenizer, "%s%stmp = snprintf(spg_at(dest, n, written), spg_left(n, written), \"%s: NULL\\n\");\n", identation, identation, name);
+    }
+    generate_advance(tokenizer, identation);
+    emit(tokenizer, "%s}\n", identation);
+}
+
+// fields that can be printed from a table of offsets, scalars and
+// strings (pointers inside unions are printed as addresses instead)
+static int is_table_field(struct field *field, int in_union)
+{
+    assert(field);
+    if (field->is_redacted || field->is_bitfield || field->dimensions_count || !field->ctype[0])
+        return 0;
+    if (field->kind == field_kind_char && field->pointers == 1)
+        return !in_union;
+    int is_scalar = field->kind >= field_kind_char && field->kind <= field_kind_float;
+    return is_scalar && !field->pointers;
+}
+
+// value printer of the type of field, added if it's new. null if
+// there are too many types already.
+static struct table_type *get_table_type(struct tokenizer *tokenizer, struct field *field)
+{
+    assert(tokenizer);
+    assert(field);
+    int is_string = field->pointers != 0;
+    for (size_t i = 0; i < tokenizer->table_types_count; i++) {
+        struct table_type *type = &tokenizer->table_types[i];
+        // every string is printed by the same function.
+        if (type->is_string == is_string && (is_string || strcmp(type->ctype, field->ctype) == 0))
+            return type;
+    }
+    if (tokenizer->table_types_count >= sizeof(tokenizer->table_types) / sizeof(*tokenizer->table_types))
+        return 0;
+    struct table_type *type = &tokenizer->table_types[tokenizer->table_types_count];
+    tokenizer->table_types_count++;
+    *type = (struct table_type) {0};
+    type->is_string = is_string;
+    append(type->ctype, sizeof(type->ctype), "%s", is_string ? "string" : field->ctype);
+    type->format = is_string ? "%s" : field_format(field);
+    return type;
+}
+
+// unsigned int -> spg_table_unsigned_int
+static void print_table_name(char *dest, size_t n, struct table_type *type)
+{
+    assert(dest);
+    assert(type);
+    append(dest, n, "spg_table_%s", type->ctype);
+    for (; *dest; dest++) {
+        if (*dest == ' ')
+            *dest = '_';
+    }
+}
+
+// spg_print_table walks a table of fields and calls the value printer
+// of each one. it returns 1 if dest is full before a selected field,
+// with written raised to n as in generate_stop, so the caller can stop.
+// the guards allow including the code of different spg_generate calls
+// in the same file.
+static void generate_table_walker(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    char *identation = "    ";
+    emit(tokenizer, "#ifndef SPG_TABLE_FIELD\n");
+    emit(tokenizer, "#define SPG_TABLE_FIELD\n");
+    emit(tokenizer, "struct spg_table_field {\n");
+    emit(tokenizer, "%sconst char *label;\n", identation);
+    emit(tokenizer, "%ssize_t offset;\n", identation);
+    emit(tokenizer, "%sunsigned long long mask;\n", identation);
+    emit(tokenizer, "%sint (*print)(char *dest, size_t n, const char *label, const void *value);\n", identation);
+    emit(tokenizer, "};\n");
+    emit(
+        tokenizer,
+        "static int spg_print_table(char *dest, int n, const void *src, const struct spg_table_field *fields, size_t count, unsigned long long mask, int measure, int *written)\n"
+    );
+    emit(tokenizer, "{\n");
+    emit(tokenizer, "%sfor (size_t i = 0; i < count; i++) {\n", identation);
+    emit(tokenizer, "%s%sif (!(mask & fields[i].mask)) continue;\n", identation, identation);
+    emit(tokenizer, "%s%sif (*written >= n - 1 && !measure) { *written = n; return 1; }\n", identation, identation);
+    emit(
+        tokenizer,
+        "%s%sint tmp = fields[i].print(spg_at(dest, n, *written), spg_left(n, *written), fields[i].label, (const char *) src + fields[i].offset);\n",
+        identation,
+        identation
+    );
+    emit(tokenizer, "%s%sif (tmp > 0) *written += tmp;\n", identation, identation);
+    emit(tokenizer, "%s}\n", identation);
+    emit(tokenizer, "%sreturn 0;\n", identation);
+    emit(tokenizer, "}\n");
+    emit(tokenizer, "#endif\n");
+}
+
+// prints one value of the type for spg_print_table.
+static void generate_table_printer(struct tokenizer *tokenizer, struct table_type *type)
+{
+    assert(tokenizer);
+    assert(type);
+    char *identation = "    ";
+    char name[128] = {0};
+    print_table_name(name, sizeof(name), type);
+    emit(tokenizer, "#ifndef %s\n", name);
+    emit(tokenizer, "#define %s %s\n", name, name);
+    emit(tokenizer, "static int %s(char *dest, size_t n, const char *label, const void *value)\n", name);
+    emit(tokenizer, "{\n");
+    if (type->is_string) {
+        emit(tokenizer, "%sconst char *text = *(const char *const *) value;\n", identation);
+        emit(tokenizer, "%sreturn text ? snprintf(dest, n, \"%%s: %%s\\n\", label, text) : snprintf(dest, n, \"%%s: NULL\\n\", label);\n", identation);
+    } else {
+        emit(tokenizer, "%sreturn snprintf(dest, n, \"%%s: %s\\n\", label, *(const %s *) value);\n", identation, type->format, type->ctype);
+    }
+    emit(tokenizer, "}\n");
+    emit(tokenizer, "#endif\n");
+}
+
+// print the fields from first on that can go in a table with a static
+// table of labels, offsets and value printers. returns the first field
+// not printed, first itself if there are too many types.
+static struct field *generate_table(struct tokenizer *tokenizer, struct field *first, const char *access, const char *label, int in_union)
+{
+    assert(tokenizer);
+    assert(first);
+    char *identation = "    ";
+    if (!get_table_type(tokenizer, first))
+        return first;
+    // src->foo.bar -> foo.bar
+    const char *designator = access + strlen("src->");
+    emit(tokenizer, "%s{\n", identation);
+    emit(tokenizer, "%sstatic const struct spg_table_field fields[] = {\n", identation);
+    struct field *field = first;
+    for (; field && is_table_field(field, in_union); field = field->next) {
+        struct table_type *type = get_table_type(tokenizer, field);
+        if (!type)
+            break;
+        tokenizer->stats.fields++;
+        char name[128] = {0};
+        print_table_name(name, sizeof(name), type);
+        char mask[32] = {0};
+        if (field->bit)
+            append(mask, sizeof(mask), "1ULL << %d", field->bit - 1);
+        else
+            append(mask, sizeof(mask), "~0ULL");
+        emit(
+            tokenizer,
+            "%s%s{\"%s%.*s\", offsetof(struct %.*s, %s%.*s), %s, %s},\n",
+            identation,
+            identation,
+            label,
+            (int) field->name.len,
+            field->name.text,
+            (int) tokenizer->struct_name.len,
+            tokenizer->struct_name.text,
+            designator,
+            (int) field->name.len,
+            field->name.text,
+            mask,
+            name
+        );
+    }
+    emit(tokenizer, "%s};\n", identation);
+    emit(
+        tokenizer,
+        "%sif (spg_print_table(dest, n, src, fields, sizeof(fields) / sizeof(*fields), mask, required != 0, &written)) goto done;\n",
+        identation
+    );
+    emit(tokenizer, "%s}\n", identation);
+    return field;
+}
+
+static void generate_fields(struct tokenizer *tokenizer, struct field *fields, const char *access, const char *label, int in_union, int loops)
+{
+    assert(tokenizer);
+    // tables use offsetof so the members must be reachable
+    // without going through pointers or array indexes.
+    int is_direct = !loops && strncmp(access, "src->", strlen("src->")) == 0 && !strstr(access + strlen("src->"), "->");
+    struct field *field = fields;
+    while (field) {
+        // a table pays off from two fields.
+        int is_table = tokenizer->compact && is_direct && is_table_field(field, in_union) && field->next && is_table_field(field->next, in_union);
+        struct field *next = is_table ? generate_table(tokenizer, field, access, label, in_union) : field;
+        if (next != field) {
+            field = next;
+            continue;
+        }
+        generate_field(tokenizer, field, access, label, in_union, loops);
+        field = field->next;
+    }
+}
+
+static void parse_generate_properties(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    // we only care about structs prefixed with "generate_properties"
+    if (!consume_keyword(tokenizer, "generate_properties"))
+        return;
+    if (token_matches(tokenizer->prev, "define"))
+        return;
+    // consume struct keyword
+    if (!consume_keyword(tokenizer, "struct"))
+        return;
+    struct token name = tokenizer->token;
+    tokenizer->struct_name = name;
+    tokenizer->stats.structs++;
+    // consume name
+    consume_token_type(tokenizer, token_identifier);
+    // consume {
+    consume_token_type(tokenizer, token_open_brace);
+    // consume properties
+    tokenizer->fields_count = 0;
+    struct field *fields = parse_members(tokenizer);
+    // }
+    consume_token_type(tokenizer, token_close_brace);
+    // don't consume it, let the main function do it.
+    // ;
+    // consume_token_type(tokenizer, token_colon);
+
+    // each member gets a bit in the mask of print_type_fields, except
+    // anonymous ones whose members are printed always.
+    int bits = 0;
+    for (struct field *field = fields; field && bits < 64; field = field->next) {
+        if (field->kind == field_kind_none || !field->name.len)
+            continue;
+        bits++;
+        field->bit = bits;
+        emit(
+            tokenizer,
+            "#define spg_field_%.*s_%.*s (1ULL << %d)\n",
+            (int) name.len,
+            name.text,
+            (int) field->name.len,
+            field->name.text,
+            bits - 1
+        );
+    }
+    // hold the function until the value printers it uses are known.
+    size_t table_types_count = tokenizer->table_types_count;
+    tokenizer->holding = tokenizer->compact;
+    if (tokenizer->instrument)
+        emit(
+            tokenizer,
+            "static struct spg_stats spg_stats_%.*s = {\"%.*s\", 0, 0, 0, 0};\n",
+            (int) name.len,
+            name.text,
+            (int) name.len,
+            name.text
+        );
+    // written counts what the fields need, which may be more than what
+    // fits in dest. once dest is full nothing else is formatted, unless
+    // required is given, then the rest is only measured.
+    emit(
+        tokenizer,
+        "int print_%.*s_fields_required(char *dest, int n, const struct %.*s *src, unsigned long long mask, int *required)\n",
+        (int) name.len,
+        name.text,
+        (int) name.len,
+        name.text
+    );
+    char *identation = "    ";
+    emit(tokenizer, "{\n");
+    if (tokenizer->instrument) {
+        emit(tokenizer, "%sspg_stats_%.*s.calls++;\n", identation, (int) name.len, name.text);
+        emit(tokenizer, "%sunsigned long long spg_start = spg_cycles();\n", identation);
+    }
+    emit(tokenizer, "%sif (required) *required = 0;\n", identation);
+    emit(tokenizer, "%sif (!src || (!dest && n > 0)) return 0;\n", identation);
+    emit(tokenizer, "%sint written = 0;\n", identation);
+    emit(tokenizer, "%sint tmp = 0;\n", identation);
+    // the struct may be printed by tables only.
+    if (tokenizer->compact)
+        emit(tokenizer, "%s(void) tmp;\n", identation);
+    emit(tokenizer, "%sif (n <= 0 && !required) goto done;\n", identation);
+    generate_fields(tokenizer, fields, "src->", "", 0, 0);
+    emit(tokenizer, "done:\n");
+    emit(tokenizer, "%sif (required) *required = written;\n", identation);
+    if (tokenizer->instrument)
+        emit(tokenizer, "%sif (written >= n) spg_stats_%.*s.truncations++;\n", identation, (int) name.len, name.text);
+    // what fits, without the null terminator.
+    emit(tokenizer, "%sif (written >= n) written = n > 0 ? n - 1 : 0;\n", identation);
+    // add null terminator to buffer
+    emit(tokenizer, "%sif (n > 0) dest[written] = 0;\n", identation);
+    if (tokenizer->instrument) {
+        emit(tokenizer, "%sspg_stats_%.*s.bytes += written;\n", identation, (int) name.len, name.text);
+        emit(tokenizer, "%sspg_stats_%.*s.cycles += spg_cycles() - spg_start;\n", identation, (int) name.len, name.text);
+    }
+    emit(tokenizer, "%sreturn written;\n", identation);
+    emit(tokenizer, "}\n");
+    emit(
+        tokenizer,
+        "int print_%.*s_fields(char *dest, int n, const struct %.*s *src, unsigned long long mask)\n",
+        (int) name.len,
+        name.text,
+        (int) name.len,
+        name.text
+    );
+    emit(tokenizer, "{\n");
+    emit(tokenizer, "%sreturn print_%.*s_fields_required(dest, n, src, mask, 0);\n", identation, (int) name.len, name.text);
+    emit(tokenizer, "}\n");
+    // print all fields.
+    emit(
+        tokenizer,
+        "int print_%.*s(char *dest, int n, const struct %.*s *src)\n",
+        (int) name.len,
+        name.text,
+        (int) name.len,
+        name.text
+    );
+    emit(tokenizer, "{\n");
+    emit(tokenizer, "%sreturn print_%.*s_fields_required(dest, n, src, ~0ULL, 0);\n", identation, (int) name.len, name.text);
+    emit(tokenizer, "}\n");
+    tokenizer->holding = 0;
+    // once per call, with the first value printers.
+    if (!table_types_count && tokenizer->table_types_count)
+        generate_table_walker(tokenizer);
+    for (size_t i = table_types_count; i < tokenizer->table_types_count; i++)
+        generate_table_printer(tokenizer, &tokenizer->table_types[i]);
+    if (tokenizer->held_len)
+        output(tokenizer, tokenizer->held, tokenizer->held_len);
+    tokenizer->held_len = 0;
+}
+
+// declare the functions of the structs of this call and the spg_print
+// macros, so they can be used before the functions are defined.
+static void generate_declarations(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    char *identation = "    ";
+    for (size_t i = tokenizer->first_generated; i < tokenizer->generated_count; i++) {
+        struct token name = tokenizer->generated[i];
+        emit(
+            tokenizer,
+            "int print_%.*s_fields_required(char *dest, int n, const struct %.*s *src, unsigned long long mask, int *required);\n",
+            (int) name.len,
+            name.text,
+            (int) name.len,
+            name.text
+        );
+        emit(
+            tokenizer,
+            "int print_%.*s_fields(char *dest, int n, const struct %.*s *src, unsigned long long mask);\n",
+            (int) name.len,
+            name.text,
+            (int) name.len,
+            name.text
+        );
+        emit(
+            tokenizer,
+            "int print_%.*s(char *dest, int n, const struct %.*s *src);\n",
+            (int) name.len,
+            name.text,
+            (int) name.len,
+            name.text
+        );
+    }
+    if (tokenizer->first_generated == tokenizer->generated_count)
+        return;
+    // where the next field goes and the room left, nothing once dest is full.
+    emit(tokenizer, "#define spg_at(dest, n, written) ((written) < (n) ? (dest) + (written) : 0)\n");
+    emit(tokenizer, "#define spg_left(n, written) ((written) < (n) ? (n) - (written) : 0)\n");
+    // spg_print(dest, n, src), spg_print_fields(dest, n, src, mask) and
+    // spg_print_fields_required(dest, n, src, mask, required) pick the
+    // function to call from the type of src at compile time. each call
+    // only selects its own structs and leaves the rest to the selection
+    // of the previous call, so the code doesn't grow with the calls.
+    char *variants[] = {"", "_fields", "_fields_required"};
+    char *parameters[] = {"", ", mask", ", mask, required"};
+    for (size_t i = 0; i < 3; i++) {
+        emit(tokenizer, "#define spg_print%s_select_%d(src) _Generic((src), \\\n", variants[i], tokenizer->generate_calls);
+        for (size_t j = tokenizer->first_generated; j < tokenizer->generated_count; j++) {
+            struct token name = tokenizer->generated[j];
+            emit(
+                tokenizer,
+                "%sstruct %.*s *: print_%.*s%s, \\\n",
+                identation,
+                (int) name.len,
+                name.text,
+                (int) name.len,
+                name.text,
+                variants[i]
+            );
+            emit(
+                tokenizer,
+                "%sconst struct %.*s *: print_%.*s%s, \\\n",
+                identation,
+                (int) name.len,
+                name.text,
+                (int) name.len,
+                name.text,
+                variants[i]
+            );
+        }
+        // the selection of other calls is compiled even if it's not
+        // picked, so it can't fail. the last one gives 0, which can't
+        // be called if src is not a struct of any call.
+        if (tokenizer->declared_call)
+            emit(tokenizer, "%sdefault: spg_print%s_select_%d(src) \\\n", identation, variants[i], tokenizer->declared_call);
+        else
+            emit(tokenizer, "%sdefault: 0 \\\n", identation);
+        emit(tokenizer, "%s)\n", identation);
+        // the code of a previous call may be included before.
+        if (tokenizer->declared_call)
+            emit(tokenizer, "#undef spg_print%s\n", variants[i]);
+        emit(
+            tokenizer,
+            "#define spg_print%s(dest, n, src%s) spg_print%s_select_%d(src)(dest, n, src%s)\n",
+            variants[i],
+            parameters[i],
+            variants[i],
+            tokenizer->generate_calls,
+            parameters[i]
+        );
+    }
+    tokenizer->declared_call = tokenizer->generate_calls;
+    // for fixed size buffers (char buf[64]; spg_print_buf(buf, &foo);)
+    emit(tokenizer, "#define spg_print_buf(buf, src) spg_print(buf, (int) sizeof(buf), src)\n");
+    emit(tokenizer, "#define spg_print_fields_buf(buf, src, mask) spg_print_fields(buf, (int) sizeof(buf), src, mask)\n");
+}
+
+// counters and cycle reading used by the instrumented print functions.
+// cycles are only read if the generated code is built with SPG_RDTSC.
+static void generate_instrumentation_header(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    if (!tokenizer->instrument)
+        return;
+    // the code of a previous call may be included before.
+    emit(tokenizer, "#ifndef SPG_STATS\n");
+    emit(tokenizer, "#define SPG_STATS\n");
+    emit(tokenizer, "struct spg_stats {\n");
+    emit(tokenizer, "    const char *name;\n");
+    emit(tokenizer, "    unsigned long long calls;\n");
+    emit(tokenizer, "    unsigned long long bytes;\n");
+    emit(tokenizer, "    unsigned long long truncations;\n");
+    emit(tokenizer, "    unsigned long long cycles;\n");
+    emit(tokenizer, "};\n");
+    emit(tokenizer, "#if defined(SPG_RDTSC) && defined(_MSC_VER)\n");
+    emit(tokenizer, "#include <intrin.h>\n");
+    emit(tokenizer, "#define spg_cycles() __rdtsc()\n");
+    emit(tokenizer, "#elif defined(SPG_RDTSC) && (defined(__x86_64__) || defined(__i386__))\n");
+    emit(tokenizer, "#include <x86intrin.h>\n");
+    emit(tokenizer, "#define spg_cycles() __rdtsc()\n");
+    emit(tokenizer, "#else\n");
+    emit(tokenizer, "#define spg_cycles() 0ULL\n");
+    emit(tokenizer, "#endif\n");
+    emit(tokenizer, "#endif\n");
+}
+
+// table with the counters of every generated function and spg_dump_stats.
+// the first spg_generate call names them spg_stats_table and
+// spg_dump_stats, the next ones spg_stats_table_2, spg_dump_stats_2...
+// which also print the counters of the calls before.
+static void generate_instrumentation_footer(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    if (!tokenizer->instrument)
+        return;
+    char *identation = "    ";
+    char suffix[32] = {0};
+    char previous[32] = {0};
+    if (tokenizer->generate_calls > 1)
+        append(suffix, sizeof(suffix), "_%d", tokenizer->generate_calls);
+    if (tokenizer->generate_calls > 2)
+        append(previous, sizeof(previous), "_%d", tokenizer->generate_calls - 1);
+    emit(tokenizer, "static struct spg_stats *spg_stats_table%s[] = {\n", suffix);
+    for (size_t i = tokenizer->first_generated; i < tokenizer->generated_count; i++) {
+        struct token name = tokenizer->generated[i];
+        emit(tokenizer, "%s&spg_stats_%.*s,\n", identation, (int) name.len, name.text);
+    }
+    emit(tokenizer, "%s0,\n", identation);
+    emit(tokenizer, "};\n");
+    if (tokenizer->generate_calls > 1)
+        emit(tokenizer, "void spg_dump_stats%s(FILE *out);\n", previous);
+    emit(tokenizer, "void spg_dump_stats%s(FILE *out)\n", suffix);
+    emit(tokenizer, "{\n");
+    if (tokenizer->generate_calls > 1)
+        emit(tokenizer, "%sspg_dump_stats%s(out);\n", identation, previous);
+    emit(tokenizer, "%sfor (struct spg_stats **stats = spg_stats_table%s; *stats; stats++)\n", identation, suffix);
+    emit(
+        tokenizer,
+        "%s%sfprintf(out, \"%%s: calls %%llu, bytes %%llu, truncations %%llu, cycles %%llu\\n\", "
+        "(*stats)->name, (*stats)->calls, (*stats)->bytes, (*stats)->truncations, (*stats)->cycles);\n",
+        identation,
+        identation
+    );
+    emit(tokenizer, "}\n");
+}
+
+static struct token path_token(const char *path)
+{
+    assert(path);
+    struct token token = {0};
+    token.text = path;
+    token.len = strlen(path);
+    return token;
+}
+
+static struct token source_name(struct tokenizer *tokenizer, size_t index)
+{
+    assert(tokenizer);
+    return path_token(tokenizer->sources[index].path);
+}
+
+// index + 1 of the last source added with path, 0 if there is none.
+static size_t find_source(struct tokenizer *tokenizer, const char *path)
+{
+    assert(tokenizer);
+    assert(path);
+    return find_name(tokenizer, &tokenizer->source_index, source_name, path_token(path));
+}
+
+// add a file to the list of files to process, which takes ownership of text.
+static void add_source(struct tokenizer *tokenizer, const char *path, char *text)
+{
+    assert(tokenizer);
+    assert(path);
+    assert(text);
+    struct source *sources = grow(tokenizer->sources, &tokenizer->sources_capacity, tokenizer->sources_count, sizeof(*sources));
+    if (!sources) {
+        emit(tokenizer, "#error \"not enough memory to process file %s\"\n", path);
+        free(text);
+        return;
+    }
+    tokenizer->sources = sources;
+    struct source *source = &tokenizer->sources[tokenizer->sources_count];
+    tokenizer->sources_count++;
+    *source = (struct source) {0};
+    append(source->path, sizeof(source->path), "%s", path);
+    if (!index_name(tokenizer, &tokenizer->source_index, source_name, tokenizer->sources_count)) {
+        tokenizer->sources_count--;
+        emit(tokenizer, "#error \"not enough memory to process file %s\"\n", path);
+        free(text);
+        return;
+    }
+    source->text = text;
+    source->size = strlen(text);
+    tokenizer->stats.bytes_scanned += source->size;
+}
+
+static int is_identifier_char(char c)
+{
+    return isalnum((unsigned char) c) || c == '_';
+}
+
+static const char *skip_blanks(const char *src)
+{
+    assert(src);
+    while (*src == ' ' || *src == '\t' || *src == '\r' || *src == '\f' || *src == '\v')
+        src++;
+    return src;
+}
+
+static struct define *find_define(struct tokenizer *tokenizer, const char *name, size_t len)
+{
+    assert(tokenizer);
+    assert(name);
+    for (size_t i = 0; i < tokenizer->defines_count; i++) {
+        if (strlen(tokenizer->defines[i].name) == len && strncmp(tokenizer->defines[i].name, name, len) == 0)
+            return &tokenizer->defines[i];
+    }
+    return 0;
+}
+
+static void add_define(struct tokenizer *tokenizer, const char *name, size_t name_len, const char *value, size_t value_len)
+{
+    assert(tokenizer);
+    assert(name);
+    assert(value);
+    struct define *define = find_define(tokenizer, name, name_len);
+    if (!define) {
+        if (tokenizer->defines_count >= sizeof(tokenizer->defines) / sizeof(*tokenizer->defines))
+            return;
+        define = &tokenizer->defines[tokenizer->defines_count];
+        tokenizer->defines_count++;
+    }
+    *define = (struct define) {0};
+    append(define->name, sizeof(define->name), "%.*s", (int) name_len, name);
+    append(define->value, sizeof(define->value), "%.*s", (int) value_len, value);
+}
+
+static void remove_define(struct tokenizer *tokenizer, const char *name, size_t len)
+{
+    assert(tokenizer);
+    struct define *define = find_define(tokenizer, name, len);
+    if (!define)
+        return;
+    tokenizer->defines_count--;
+    *define = tokenizer->defines[tokenizer->defines_count];
+}
+
+// -DNAME or -DNAME=value
+static void add_define_flag(struct tokenizer *tokenizer, const char *flag)
+{
+    assert(tokenizer);
+    assert(flag);
+    const char *value = strchr(flag, '=');
+    if (value)
+        add_define(tokenizer, flag, value - flag, value + 1, strlen(value + 1));
+    else
+        add_define(tokenizer, flag, strlen(flag), "1", 1);
+}
+
+// evaluation of #if expressions. only integers, defined,
+// macros, parenthesis and the ! - + == != < > <= >= && || operators
+// are supported. anything else evaluates to 0.
+struct expression {
+    struct tokenizer *tokenizer;
+    const char *cursor;
+    // how many macros are being expanded.
+    int depth;
+    // macros expanded so far, (#define a b + b, #define b c + c, ...)
+    // would take exponential time otherwise.
+    int expansions;
+};
+
+static long evaluate_or(struct expression *expression);
+
+static int consume_operator(struct expression *expression, const char *operator)
+{
+    assert(expression);
+    assert(operator);
+    expression->cursor = skip_blanks(expression->cursor);
+    size_t len = strlen(operator);
+    if (strncmp(expression->cursor, operator, len) != 0)
+        return 0;
+    // don't take the < of <= or the ! of !=
+    if (len == 1 && expression->cursor[1] == '=' && *operator != '=')
+        return 0;
+    expression->cursor += len;
+    return 1;
+}
+
+static long evaluate_unary(struct expression *expression)
+{
+    assert(expression);
+    const char *cursor = skip_blanks(expression->cursor);
+    expression->cursor = cursor;
+    if (consume_operator(expression, "!"))
+        return !evaluate_unary(expression);
+    if (consume_operator(expression, "-"))
+        return (long) (0UL - (unsigned long) evaluate_unary(expression));
+    if (consume_operator(expression, "+"))
+        return evaluate_unary(expression);
+    if (consume_operator(expression, "(")) {
+        long result = evaluate_or(expression);
+        consume_operator(expression, ")");
+        return result;
+    }
+    if (isdigit((unsigned char) *cursor)) {
+        char *end = 0;
+        long result = strtol(cursor, &end, 0);
+        // suffixes (1UL)
+        while (*end == 'u' || *end == 'U' || *end == 'l' || *end == 'L')
+            end++;
+        expression->cursor = end;
+        return result;
+    }
+    if (is_identifier_char(*cursor)) {
+        const char *name = cursor;
+        while (is_identifier_char(*cursor))
+            cursor++;
+        size_t len = cursor - name;
+        expression->cursor = cursor;
+        if (len == strlen("defined") && strncmp(name, "defined", len) == 0) {
+            int parenthesis = consume_operator(expression, "(");
+            cursor = skip_blanks(expression->cursor);
+            name = cursor;
+            while (is_identifier_char(*cursor))
+                cursor++;
+            expression->cursor = cursor;
+            if (parenthesis)
+                consume_operator(expression, ")");
+            return find_define(expression->tokenizer, name, cursor - name) != 0;
+        }
+        // function like macros are not expanded.
+        if (consume_operator(expression, "(")) {
+            int parenthesis = 1;
+            while (*expression->cursor && parenthesis) {
+                if (*expression->cursor == '(')
+                    parenthesis++;
+                if (*expression->cursor == ')')
+                    parenthesis--;
+                expression->cursor++;
+            }
+            return 0;
+        }
+        struct define *define = find_define(expression->tokenizer, name, len);
+        if (!define || expression->depth >= 16 || expression->expansions >= 256)
+            return 0;
+        expression->expansions++;
+        // evaluate the value of the macro and continue where we were.
+        expression->cursor = define->value;
+        expression->depth++;
+        long result = evaluate_or(expression);
+        expression->depth--;
+        expression->cursor = cursor;
+        return result;
+    }
+    // unexpected character, skip it.
+    if (*cursor)
+        expression->cursor++;
+    return 0;
+}
+
+static long evaluate_additive(struct expression *expression)
+{
+    assert(expression);
+    long result = evaluate_unary(expression);
+    for (;;) {
+        // unsigned to prevent overflows.
+        if (consume_operator(expression, "+"))
+            result = (long) ((unsigned long) result + (unsigned long) evaluate_unary(expression));
+        else if (consume_operator(expression, "-"))
+            result = (long) ((unsigned long) result - (unsigned long) evaluate_unary(expression));
+        else
+            return result;
+    }
+}
+
+static long evaluate_compare(struct expression *expression)
+{
+    assert(expression);
+    long result = evaluate_additive(expression);
+    for (;;) {
+        if (consume_operator(expression, "=="))
+            result = result == evaluate_additive(expression);
+        else if (consume_operator(expression, "!="))
+            result = result != evaluate_additive(expression);
+        else if (consume_operator(expression, "<="))
+            result = result <= evaluate_additive(expression);
+        else if (consume_operator(expression, ">="))
+            result = result >= evaluate_additive(expression);
+        else if (consume_operator(expression, "<"))
+            result = result < evaluate_additive(expression);
+        else if (consume_operator(expression, ">"))
+            result = result > evaluate_additive(expression);
+        else
+            return result;
+    }
+}
+
+static long evaluate_and(struct expression *expression)
+{
+    assert(expression);
+    long result = evaluate_compare(expression);
+    while (consume_operator(expression, "&&")) {
+        long right = evaluate_compare(expression);
+        result = result && right;
+    }
+    return result;
+}
+
+static long evaluate_or(struct expression *expression)
+{
+    assert(expression);
+    long result = evaluate_and(expression);
+    while (consume_operator(expression, "||")) {
+        long right = evaluate_and(expression);
+        result = result || right;
+    }
+    return result;
+}
+
+static long evaluate(struct tokenizer *tokenizer, const char *src)
+{
+    assert(tokenizer);
+    assert(src);
+    struct expression expression = {0};
+    expression.tokenizer = tokenizer;
+    expression.cursor = src;
+    return evaluate_or(&expression);
+}
+
+// files being included, used to prevent include cycles.
+struct include {
+    const char *path;
+    struct include *parent;
+    int depth;
+};
+
+static void preprocess_file(struct tokenizer *tokenizer, const char *path, char *text, struct include *parent);
+
+// handle a directive (without the #) found in the file being preprocessed.
+static void preprocess_directive(
+    struct tokenizer *tokenizer,
+    const char *directive,
+    struct include *include,
+    struct condition *conditions,
+    size_t *conditions_count,
+    size_t *ignored_conditions
+)
+{
+    assert(tokenizer);
+    assert(directive);
+    assert(include);
+    assert(conditions);
+    assert(conditions_count);
+    assert(ignored_conditions);
+    int active = *conditions_count == 0 || conditions[*conditions_count - 1].active;
+    const char *cursor = skip_blanks(directive);
+    const char *name = cursor;
+    while (is_identifier_char(*cursor))
+        cursor++;
+    struct token keyword = {0};
+    keyword.text = name;
+    keyword.len = cursor - name;
+    cursor = skip_blanks(cursor);
+
+    int is_ifdef = token_matches(keyword, "ifdef");
+    int is_ifndef = token_matches(keyword, "ifndef");
+    if (is_ifdef || is_ifndef || token_matches(keyword, "if")) {
+        // too many nested blocks, the content is left as is.
+        if (*conditions_count >= 64) {
+            (*ignored_conditions)++;
+            return;
+        }
+        int condition = 0;
+        struct condition *new_condition = &conditions[*conditions_count];
+        (*conditions_count)++;
+        if (active && (is_ifdef || is_ifndef)) {
+            const char *end = cursor;
+            while (is_identifier_char(*end))
+                end++;
+            condition = find_define(tokenizer, cursor, end - cursor) != 0;
+            if (is_ifndef)
+                condition = !condition;
+        } else if (active) {
+            condition = evaluate(tokenizer, cursor) != 0;
+        }
+        new_condition->parent_active = active;
+        new_condition->active = active && condition;
+        new_condition->taken = new_condition->active;
+        return;
+    }
+    if (token_matches(keyword, "elif") || token_matches(keyword, "else")) {
+        if (*ignored_conditions || !*conditions_count)
+            return;
+        struct condition *condition = &conditions[*conditions_count - 1];
+        int is_else = token_matches(keyword, "else");
+        if (!condition->parent_active || condition->taken)
+            condition->active = 0;
+        else
+            condition->active = is_else || evaluate(tokenizer, cursor) != 0;
+        if (condition->active)
+            condition->taken = 1;
+        return;
+    }
+    if (token_matches(keyword, "endif")) {
+        if (*ignored_conditions)
+            (*ignored_conditions)--;
+        else if (*conditions_count)
+            (*conditions_count)--;
+        return;
+    }
+    if (!active)
+        return;
+    if (token_matches(keyword, "define") || token_matches(keyword, "undef")) {
+        name = cursor;
+        while (is_identifier_char(*cursor))
+            cursor++;
+        size_t name_len = cursor - name;
+        if (!name_len)
+            return;
+        if (token_matches(keyword, "undef")) {
+            remove_define(tokenizer, name, name_len);
+            return;
+        }
+        const char *value = skip_blanks(cursor);
+        size_t value_len = strlen(value);
+        while (value_len && isspace((unsigned char) value[value_len - 1]))
+            value_len--;
+        add_define(tokenizer, name, name_len, value, value_len);
+        return;
+    }
+    // only "quoted" includes are followed.
+    if (token_matches(keyword, "include") && *cursor == '"' && !tokenizer->skip_includes) {
+        const char *file = cursor + 1;
+        const char *end = strchr(file, '"');
+        if (!end)
+            return;
+        char included[260] = {0};
+        int is_absolute = *file == '/' || *file == '\\' || (*file && file[1] == ':');
+        if (!is_absolute) {
+            // relative to the file including it.
+            const char *directory_end = 0;
+            for (const char *c = include->path; *c; c++) {
+                if (*c == '/' || *c == '\\')
+                    directory_end = c + 1;
+            }
+            if (directory_end)
+                append(included, sizeof(included), "%.*s", (int) (directory_end - include->path), include->path);
+        }
+        append(included, sizeof(included), "%.*s", (int) (end - file), file);
+        preprocess_file(tokenizer, included, 0, include);
+    }
+}
+
+// blank everything but new lines from start to end.
+static void blank(char *start, const char *end)
+{
+    assert(start);
+    assert(end);
+    for (; start < end; start++) {
+        if (*start != '\n')
+            *start = ' ';
+    }
+}
+
+// preprocess the text of a file in place, the content of inactive blocks
+// and directives get replaced with spaces so the rest of the program
+// doesn't have to deal with them.
+static void preprocess_text(struct tokenizer *tokenizer, struct include *include, char *text)
+{
+    assert(tokenizer);
+    assert(include);
+    assert(text);
+    struct condition conditions[64] = {0};
+    size_t conditions_count = 0;
+    size_t ignored_conditions = 0;
+    char *src = text;
+    while (*src) {
+        char *line = src;
+        while (*src == ' ' || *src == '\t')
+            src++;
+        if (*src == '#') {
+            // copy the directive without comments and line continuations.
+            char directive[512] = {0};
+            size_t len = 0;
+            src++;
+            while (*src && *src != '\n') {
+                if (src[0] == '\\' && src[1] == '\n') {
+                    src += 2;
+                    continue;
+                }
+                if (src[0] == '\\' && src[1] == '\r' && src[2] == '\n') {
+                    src += 3;
+                    continue;
+                }
+                if (src[0] == '/' && src[1] == '/') {
+                    while (*src && *src != '\n')
+                        src++;
+                    break;
+                }
+                if (src[0] == '/' && src[1] == '*') {
+                    src += 2;
+                    while (*src && !(src[0] == '*' && src[1] == '/'))
+                        src++;
+                    if (*src)
+                        src += 2;
+                    if (len + 1 < sizeof(directive))
+                        directive[len++] = ' ';
+                    continue;
+                }
+                if (len + 1 < sizeof(directive))
+                    directive[len++] = *src;
+                src++;
+            }
+            directive[len] = 0;
+            blank(line, src);
+            preprocess_directive(tokenizer, directive, include, conditions, &conditions_count, &ignored_conditions);
+            continue;
+        }
+        while (*src && *src != '\n') {
+            // skip comments and strings so # found inside
+            // them are not taken as directives.
+            if (src[0] == '/' && src[1] == '/') {
+                while (*src && *src != '\n')
+                    src++;
+            } else if (src[0] == '/' && src[1] == '*') {
+                src += 2;
+                while (*src && !(src[0] == '*' && src[1] == '/'))
+                    src++;
+                if (*src)
+                    src += 2;
+            } else if (*src == '"' || *src == '\'') {
+                char quote = *src;
+                src++;
+                while (*src && *src != quote && *src != '\n') {
+                    if (*src == '\\' && src[1])
+                        src++;
+                    src++;
+                }
+                if (*src == quote)
+                    src++;
+            } else {
+                src++;
+            }
+        }
+        if (conditions_count && !conditions[conditions_count - 1].active)
+            blank(line, src);
+        if (*src == '\n')
+            src++;
+    }
+}
+
+// preprocess a file, which takes ownership of text or, if null, reads it.
+// included files are added to the list of sources before the file
+// including them. an included file is added only once per context,
+// the files and buffers given to spg_generate once per call.
+static void preprocess_file(struct tokenizer *tokenizer, const char *path, char *text, struct include *parent)
+{
+    assert(tokenizer);
+    assert(path);
+    size_t found = find_source(tokenizer, path);
+    if (found && (parent || found > tokenizer->first_source)) {
+        if (!parent)
+            emit(tokenizer, "// file: %s was already processed.\n", path);
+        free(text);
+        return;
+    }
+    for (struct include *include = parent; include; include = include->parent) {
+        if (strcmp(include->path, path) == 0) {
+            free(text);
+            return;
+        }
+    }
+    struct include include = {0};
+    include.path = path;
+    include.parent = parent;
+    include.depth = parent ? parent->depth + 1 : 0;
+    if (include.depth > 64) {
+        free(text);
+        return;
+    }
+    if (!text)
+        text = read_file(path);
+    if (!text) {
+        emit(tokenizer, "// file: %s was not able to be processed.\n", path);
+        return;
+    }
+    preprocess_text(tokenizer, &include, text);
+    add_source(tokenizer, path, text);
+}
+
+// tokenizing is done lazily while parsing so, to find out
+// its cost alone, the sources get tokenized an extra time.
+static void tokenize_sources(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    struct source *sources = tokenizer->sources;
+    double start = get_time();
+    for (size_t i = tokenizer->first_source; i < tokenizer->sources_count; i++) {
+        struct token token = get_token(sources[i].text);
+        while (token.type != token_eof) {
+            sources[i].tokens++;
+            token = get_token(token.text + token.len);
+        }
+        tokenizer->stats.tokens += sources[i].tokens;
+    }
+    tokenizer->stats.tokenize_time += get_time() - start;
+}
+
+// find the typedefs of the sources added since the last call and
+// then generate the print functions of their structs.
+static void generate_sources(struct tokenizer *tokenizer)
+{
+    assert(tokenizer);
+    struct source *sources = tokenizer->sources;
+    for (size_t i = tokenizer->first_source; i < tokenizer->sources_count; i++) {
+        double start = get_time();
+        tokenizer->file = sources[i].text;
+        tokenizer->cursor = 0;
+        tokenizer->token = (struct token) {0};
+        tokenizer->prev = (struct token) {0};
+        while (tokenizer->token.type != token_eof) {
+            consume_token(tokenizer);
+            parse_generated(tokenizer);
+            parse_typedef(tokenizer);
+        }
+        sources[i].typedef_time = get_time() - start;
+        tokenizer->stats.typedef_time += sources[i].typedef_time;
+    }
+    generate_declarations(tokenizer);
+    // for (size_t i = 0; i < tokenizer->aliases_count; i++) {
+    //     printf("parent\n");
+    //     print_token(tokenizer->aliases[i].parent);
+    //     printf("alias\n");
+    //     print_token(tokenizer->aliases[i].alias);
+    //     printf("\n\n");
+    // }
+    for (size_t i = tokenizer->first_source; i < tokenizer->sources_count; i++) {
+        double start = get_time();
+        tokenizer->file = sources[i].text;
+        // reset tokenizer
+        tokenizer->cursor = 0;
+        tokenizer->token = (struct token) {0};
+        tokenizer->prev = (struct token) {0};
+        while (tokenizer->token.type != token_eof) {
+            consume_token(tokenizer);
+            parse_generate_properties(tokenizer);
+        }
+        sources[i].emit_time = get_time() - start;
+        tokenizer->stats.emit_time += sources[i].emit_time;
+    }
+    generate_instrumentation_footer(tokenizer);
+}
+
+// write a json string, escaping quotes, backslashes and control characters.
+static void print_json_string(FILE *out, const char *text)
+{
+    assert(out);
+    assert(text);
+    fputc('"', out);
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\')
+            fprintf(out, "\\%c", *text);
+        else if ((unsigned char) *text < 0x20)
+            fprintf(out, "\\u%04x", (unsigned char) *text);
+        else
+            fputc(*text, out);
+    }
+    fputc('"', out);
+}
+
+// times are printed in milliseconds.
+static void print_stats(FILE *out, struct tokenizer *tokenizer)
+{
+    assert(out);
+    assert(tokenizer);
+    struct stats *stats = &tokenizer->stats;
+    struct source *sources = tokenizer->sources;
+    fprintf(out, "{\"phases_ms\": {");
+    fprintf(out, "\"read\": %.3f, ", stats->read_time * 1000);
+    fprintf(out, "\"tokenize\": %.3f, ", stats->tokenize_time * 1000);
+    fprintf(out, "\"typedef\": %.3f, ", stats->typedef_time * 1000);
+    fprintf(out, "\"emit\": %.3f}, ", stats->emit_time * 1000);
+    fprintf(out, "\"bytes_scanned\": %lu, ", (unsigned long) stats->bytes_scanned);
+    fprintf(out, "\"tokens\": %lu, ", (unsigned long) stats->tokens);
+    fprintf(out, "\"aliases\": %lu, ", (unsigned long) tokenizer->aliases_count);
+    fprintf(out, "\"alias_lookups\": %lu, ", (unsigned long) stats->alias_lookups);
+    fprintf(out, "\"alias_max_depth\": %lu, ", (unsigned long) stats->alias_max_depth);
+    fprintf(out, "\"structs\": %lu, ", (unsigned long) stats->structs);
+    fprintf(out, "\"fields\": %lu, ", (unsigned long) stats->fields);
+    fprintf(out, "\"output_bytes\": %lu, ", (unsigned long) stats->output_bytes);
+    fprintf(out, "\"files\": [");
+    for (size_t i = 0; i < tokenizer->sources_count; i++) {
+        fprintf(out, "%s{\"path\": ", i ? ", " : "");
+        print_json_string(out, sources[i].path);
+        fprintf(out, ", \"bytes\": %lu, ", (unsigned long) sources[i].size);
+        fprintf(out, "\"tokens\": %lu, ", (unsigned long) sources[i].tokens);
+        fprintf(out, "\"typedef_ms\": %.3f, ", sources[i].typedef_time * 1000);
+        fprintf(out, "\"emit_ms\": %.3f}", sources[i].emit_time * 1000);
+    }
+    fprintf(out, "]}\n");
+}
+
+
+struct spg_context {
+    struct tokenizer tokenizer;
+};
+
+struct spg_context *spg_context_create(void)
+{
+    // way too big for the stack.
+    struct spg_context *context = calloc(1, sizeof(struct spg_context));
+    if (context)
+        context->tokenizer.source_index.keep_last = 1;
+    return context;
+}
+
+void spg_context_destroy(struct spg_context *context)
+{
+    if (!context)
+        return;
+    struct tokenizer *tokenizer = &context->tokenizer;
+    for (size_t i = 0; i < tokenizer->inputs_count; i++)
+        free(tokenizer->inputs[i].text);
+    for (size_t i = 0; i < tokenizer->sources_count; i++)
+        free(tokenizer->sources[i].text);
+    free(tokenizer->inputs);
+    free(tokenizer->sources);
+    free(tokenizer->aliases);
+    free(tokenizer->alias_index.slots);
+    free(tokenizer->generated_index.slots);
+    free(tokenizer->source_index.slots);
+    free(tokenizer->generated);
+    free(tokenizer->held);
+    free(context);
+}
+
+void spg_set_options(struct spg_context *context, int options)
+{
+    assert(context);
+    struct tokenizer *tokenizer = &context->tokenizer;
+    tokenizer->compact = (options & spg_option_compact) != 0;
+    tokenizer->instrument = (options & spg_option_instrument) != 0;
+    tokenizer->preprocess = (options & spg_option_preprocess) != 0;
+    tokenizer->skip_includes = (options & spg_option_no_includes) != 0;
+    tokenizer->tokenize = (options & spg_option_stats) != 0;
+}
+
+void spg_define(struct spg_context *context, const char *flag)
+{
+    assert(context);
+    assert(flag);
+    add_define_flag(&context->tokenizer, flag);
+}
+
+// add a file for the next spg_generate call, which takes ownership of text.
+static int add_input(struct tokenizer *tokenizer, const char *path, char *text)
+{
+    assert(tokenizer);
+    assert(path);
+    struct input *inputs = grow(tokenizer->inputs, &tokenizer->inputs_capacity, tokenizer->inputs_count, sizeof(*inputs));
+    if (!inputs) {
+        free(text);
+        return 0;
+    }
+    tokenizer->inputs = inputs;
+    struct input *input = &tokenizer->inputs[tokenizer->inputs_count];
+    tokenizer->inputs_count++;
+    *input = (struct input) {0};
+    append(input->path, sizeof(input->path), "%s", path);
+    input->text = text;
+    return text != 0;
+}
+
+int spg_add_buffer(struct spg_context *context, const char *name, const char *data, size_t len)
+{
+    assert(context);
+    assert(name);
+    assert(data || !len);
+    char *text = malloc(len + 1);
+    if (!text)
+        return 0;
+    if (len)
+        memcpy(text, data, len);
+    text[len] = 0;
+    return add_input(&context->tokenizer, name, text);
+}
+
+int spg_add_file(struct spg_context *context, const char *path)
+{
+    assert(context);
+    assert(path);
+    double start = get_time();
+    char *text = read_file(path);
+    context->tokenizer.stats.read_time += get_time() - start;
+    // files that can't be read are still added to leave
+    // a comment in the generated code.
+    return add_input(&context->tokenizer, path, text);
+}
+
+size_t spg_generate(struct spg_context *context, struct spg_sink *sink)
+{
+    assert(context);
+    struct tokenizer *tokenizer = &context->tokenizer;
+    size_t output_bytes = tokenizer->stats.output_bytes;
+    tokenizer->sink = sink;
+    tokenizer->first_source = tokenizer->sources_count;
+    tokenizer->first_generated = tokenizer->generated_count;
+    tokenizer->table_types_count = 0;
+    tokenizer->generate_calls++;
+    // add includes
+    emit(tokenizer, "#include <stddef.h>\n");
+    emit(tokenizer, "#include <stdio.h>\n");
+    generate_instrumentation_header(tokenizer);
+    double start = get_time();
+    for (size_t i = 0; i < tokenizer->inputs_count; i++) {
+        struct input *input = &tokenizer->inputs[i];
+        if (!input->text)
+            emit(tokenizer, "// file: %s was not able to be processed.\n", input->path);
+        else if (tokenizer->preprocess)
+            preprocess_file(tokenizer, input->path, input->text, 0);
+        else
+            add_source(tokenizer, input->path, input->text);
+    }
+    tokenizer->inputs_count = 0;
+    tokenizer->stats.read_time += get_time() - start;
+    if (tokenizer->tokenize)
+        tokenize_sources(tokenizer);
+    generate_sources(tokenizer);
+    tokenizer->sink = 0;
+    return tokenizer->stats.output_bytes - output_bytes;
+}
+
+void spg_write_stats(struct spg_context *context, FILE *out)
+{
+    assert(context);
+    assert(out);
+    print_stats(out, &context->tokenizer);
+}
@@ -0,0 +1,60 @@
+// struct property generator as a library.
+//
+// struct spg_context *context = spg_context_create();
+// spg_add_file(context, "file.h");
+// spg_add_buffer(context, "other.h", data, len);
+// spg_generate(context, &sink);
+// spg_context_destroy(context);
+//
+// typedefs found by spg_generate are kept in the context, so the buffers
+// added for the next call can use them without being parsed again.
+#ifndef SPG_H
+#define SPG_H
+
+#include <stddef.h> // size_t
+#include <stdio.h>  // FILE
+
+// options for spg_set_options, same as the ones of the command line.
+enum spg_option {
+    // --compact
+    spg_option_compact = 1 << 0,
+    // --instrument
+    spg_option_instrument = 1 << 1,
+    // --preprocess
+    spg_option_preprocess = 1 << 2,
+    // don't read the files of #include "file" (untrusted buffers)
+    spg_option_no_includes = 1 << 3,
+    // --stats, time tokenizing on its own (see spg_write_stats)
+    spg_option_stats = 1 << 4,
+};
+
+// receives the generated code.
+struct spg_sink {
+    void (*write)(void *user, const char *text, size_t len);
+    void *user;
+};
+
+struct spg_context;
+
+// null if there is not enough memory.
+struct spg_context *spg_context_create(void);
+void spg_context_destroy(struct spg_context *context);
+// combination of spg_option.
+void spg_set_options(struct spg_context *context, int options);
+// NAME or NAME=value, same as -D.
+void spg_define(struct spg_context *context, const char *flag);
+// add the content of a header, data is copied. name is used to
+// resolve #include "file" and in the stats. returns 0 if there is
+// not enough memory.
+int spg_add_buffer(struct spg_context *context, const char *name, const char *data, size_t len);
+// add a header from disk. returns 0 if it can't be read.
+int spg_add_file(struct spg_context *context, const char *path);
+// generate the code of everything added since the last call. if sink
+// is null the code is only measured. returns the size of the code.
+// the code uses the declarations of the previous calls, so it has to
+// be included after theirs.
+size_t spg_generate(struct spg_context *context, struct spg_sink *sink);
+// --stats json of all the calls made so far.
+void spg_write_stats(struct spg_context *context, FILE *out);
+
+#endif
@@ -3,7 +3,62 @@
 #include <string.h>
 #include "examples/file.h"
 #include "examples/file2.h"
+// build with -DCOMPACT to test the code generated with --compact,
+// -DINSTRUMENT for the code generated with --instrument,
+// -DPREPROCESS for the code generated with --preprocess
+// or -DLIBRARY (along with spg.c) to test the library too.
+#if defined(COMPACT)
+#include "examples/generated_compact.c"
+#elif defined(INSTRUMENT)
+#include "examples/generated_instrument.c"
+#elif defined(PREPROCESS)
+#define SPG_EXTRA_FIELD 1
+#include "examples/file3.h"
+#include "examples/generated_preprocess.c"
+#else
 #include "examples/generated.c"
+#endif
+
+#ifdef LIBRARY
+#include "spg.h"
+
+struct buffer {
+    char text[1 << 16];
+    size_t len;
+};
+
+static void write_buffer(void *user, const char *text, size_t len)
+{
+    struct buffer *buffer = user;
+    assert(buffer->len + len < sizeof(buffer->text));
+    memcpy(buffer->text + buffer->len, text, len);
+    buffer->len += len;
+    buffer->text[buffer->len] = 0;
+}
+
+// the content of a file without \r
+static void read_text(struct buffer *buffer, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    assert(file);
+    int c = 0;
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '\r')
+            continue;
+        assert(buffer->len + 1 < sizeof(buffer->text));
+        buffer->text[buffer->len++] = (char) c;
+    }
+    buffer->text[buffer->len] = 0;
+    fclose(file);
+}
+#endif
+
+// struct external isn't generated, its print function is written by hand.
+int print_external(char *dest, int n, const struct external *src)
+{
+    int written = snprintf(dest, n, "id: %d\n", src->id);
+    return written < n ? written : (n > 0 ? n - 1 : 0);
+}
 
 int main(void)
 {
@@ -39,6 +94,7 @@ int main(void)
         "custom_type: %d\n"
         "st.foo: %d\n"
         "is.baz: %d\n"
+        "ignore_me.foo: %d\n"
         "another_property: %d\n"
         ,
         s.bar[0],
@@ -53,6 +109,7 @@ int main(void)
         s.custom_type,
         s.st.foo,
         s.is.baz,
+        s.ignore_me.foo,
         s.another_property
     );
     printf("--\n");
@@ -60,6 +117,231 @@ int main(void)
     printf("%s", expected);
     assert(strcmp(buf, expected) == 0);
     printf("\n\n");
+
+    int value = 7;
+    int *value_pointer = &value;
+    struct struct_as_type nested = {0};
+    nested.foo = 5;
+    struct nested_types t = {0};
+    t.matrix[0][1] = 1;
+    t.matrix[1][2] = 12;
+    t.double_pointer = &value_pointer;
+    t.names[0] = "first";
+    strcpy(t.rows[0], "row");
+    memcpy(t.rows[1], "12345678", 8);
+    t.point.x = 3;
+    t.point.y = 1.5f;
+    t.items[1].id = 9;
+    t.value.as_int = 11;
+    t.anonymous = 100;
+    t.nested = &nested;
+    char nested_buf[1024] = {0};
+    print_nested_types(nested_buf, sizeof(nested_buf), &t);
+    printf("generated:\n");
+    printf("%s", nested_buf);
+    char nested_expected[1024] = {0};
+    snprintf(
+        nested_expected,
+        sizeof(nested_expected),
+        "matrix: 0\n"
+        "matrix: 1\n"
+        "matrix: 0\n"
+        "matrix: 0\n"
+        "matrix: 0\n"
+        "matrix: 12\n"
+        "double_pointer: 7\n"
+        "names: first\n"
+        "names: NULL\n"
+        "rows: row\n"
+        "rows: 12345678\n"
+        "point.x: 3\n"
+        "point.y: %f\n"
+        "items.id: 0\n"
+        "items.id: 9\n"
+        "no_items: NULL\n"
+        "value.as_int: 11\n"
+        "value.as_string: %p\n"
+        "value.as_point: %p\n"
+        "anonymous: 100\n"
+        "nested.foo: 5\n"
+        ,
+        t.point.y,
+        (void *) t.value.as_string,
+        (void *) t.value.as_point
+    );
+    printf("--\n");
+    printf("expected:\n");
+    printf("%s", nested_expected);
+    assert(strcmp(nested_buf, nested_expected) == 0);
+    printf("\n\n");
+
+    struct counters c = {0};
+    c.hits = 10;
+    c.misses = 2;
+    c.evictions = 1;
+    c.level = 3;
+    c.hit_rate = 0.8;
+    c.miss_rate = 0.2;
+    c.time.started = 100;
+    c.time.finished = 250;
+    c.grade = 'A';
+    char counters_buf[256] = {0};
+    print_counters(counters_buf, sizeof(counters_buf), &c);
+    printf("generated:\n");
+    printf("%s", counters_buf);
+    char counters_expected[256] = {0};
+    snprintf(
+        counters_expected,
+        sizeof(counters_expected),
+        "hits: 10\n"
+        "misses: 2\n"
+        "evictions: 1\n"
+        "level: 3\n"
+        "hit_rate: %f\n"
+        "miss_rate: %f\n"
+        "time.started: 100\n"
+        "time.finished: 250\n"
+        "grade: A\n"
+        ,
+        c.hit_rate,
+        c.miss_rate
+    );
+    printf("--\n");
+    printf("expected:\n");
+    printf("%s", counters_expected);
+    assert(strcmp(counters_buf, counters_expected) == 0);
+    printf("\n\n");
+
+    char masked_buf[256] = {0};
+    print_counters_fields(masked_buf, sizeof(masked_buf), &c, spg_field_counters_misses | spg_field_counters_time);
+    printf("generated:\n");
+    printf("%s", masked_buf);
+    printf("--\n");
+    assert(strcmp(masked_buf, "misses: 2\ntime.started: 100\ntime.finished: 250\n") == 0);
+    print_counters_fields(masked_buf, sizeof(masked_buf), &c, 0);
+    assert(strcmp(masked_buf, "") == 0);
+
+    struct session session = {0};
+    session.user_id = 1;
+    session.token = "secret token";
+    session.password = "secret password";
+    session.flags = 3;
+    print_session(masked_buf, sizeof(masked_buf), &session);
+    printf("%s", masked_buf);
+    printf("--\n");
+    assert(strcmp(masked_buf, "user_id: 1\ntoken: [redacted]\nflags: 3\n") == 0);
+    print_session_fields(masked_buf, sizeof(masked_buf), &session, spg_field_session_flags);
+    printf("%s", masked_buf);
+    assert(strcmp(masked_buf, "flags: 3\n") == 0);
+    printf("\n\n");
+
+    // members of structs that aren't generated use their print function.
+    struct with_external with_external = {{5}, 1};
+    print_with_external(masked_buf, sizeof(masked_buf), &with_external);
+    printf("%s", masked_buf);
+    assert(strcmp(masked_buf, "ext.id: 5\nafter: 1\n") == 0);
+    printf("\n\n");
+
+    // spg_print picks the print function from the type.
+    const struct session *const_session = &session;
+    char session_buf[64] = {0};
+    spg_print_buf(session_buf, const_session);
+    printf("%s", session_buf);
+    assert(strcmp(session_buf, "user_id: 1\ntoken: [redacted]\nflags: 3\n") == 0);
+    spg_print_fields_buf(session_buf, &session, spg_field_session_user_id);
+    assert(strcmp(session_buf, "user_id: 1\n") == 0);
+    spg_print(masked_buf, sizeof(masked_buf), &s.st);
+    assert(strcmp(masked_buf, "foo: 9999\n") == 0);
+    printf("\n\n");
+
+    // output that doesn't fit gets cut and the size
+    // it needs is reported apart.
+    char small_buf[8] = {0};
+    int required = 0;
+    int small_len = print_session_fields_required(small_buf, sizeof(small_buf), &session, ~0ULL, &required);
+    assert(strcmp(small_buf, "user_id") == 0);
+    assert(small_len == 7);
+    assert(required == (int) strlen("user_id: 1\ntoken: [redacted]\nflags: 3\n"));
+    assert(print_session(small_buf, sizeof(small_buf), &session) == 7);
+    // nested structs don't write past the end either.
+    print_some_other_struct_fields_required(small_buf, sizeof(small_buf), &s, spg_field_some_other_struct_st, &required);
+    assert(strcmp(small_buf, "st.foo:") == 0);
+    assert(required == (int) strlen("st.foo: 9999\n"));
+    // only measure.
+    print_some_other_struct_fields_required(0, 0, &s, ~0ULL, &required);
+    assert(required == (int) strlen(buf));
+    // a field that ends right at the last usable byte leaves the
+    // next one out, which is a truncation. as the last field, it isn't.
+    struct foo exact = {1, "x"};
+    assert(print_foo(small_buf, sizeof(small_buf), &exact) == 7);
+    assert(strcmp(small_buf, "bar: 1\n") == 0);
+    assert(print_foo_fields(small_buf, sizeof(small_buf), &exact, spg_field_foo_bar) == 7);
+    assert(strcmp(small_buf, "bar: 1\n") == 0);
+
+#ifdef PREPROCESS
+    struct preprocessed p = {0};
+    p.value = 4;
+    p.extra = 2;
+    print_preprocessed(masked_buf, sizeof(masked_buf), &p);
+    printf("%s", masked_buf);
+    assert(strcmp(masked_buf, "value: 4\nextra: 2\n") == 0);
+    printf("\n\n");
+#endif
+
+#ifdef LIBRARY
+    // same code as spg.linux examples/file.h examples/file2.h
+    static struct buffer generated = {0};
+    static struct buffer expected_generated = {0};
+    struct spg_sink sink = {write_buffer, &generated};
+    struct spg_context *context = spg_context_create();
+    assert(context);
+    assert(spg_add_file(context, "examples/file.h"));
+    assert(spg_add_file(context, "examples/file2.h"));
+    assert(spg_generate(context, &sink) == generated.len);
+    read_text(&expected_generated, "examples/generated.c");
+    assert(strcmp(generated.text, expected_generated.text) == 0);
+    // typedefs of file2.h are still known in the next call.
+    const char *header = "generate_properties struct library { yet_another_custom_type value; };";
+    generated.len = 0;
+    assert(spg_add_buffer(context, "library.h", header, strlen(header)));
+    spg_generate(context, &sink);
+    printf("%s", generated.text);
+    assert(strstr(generated.text, "\"value: %d\\n\", src->value"));
+    // only the code of the new structs.
+    assert(!strstr(generated.text, "int print_foo(char *dest, int n, const struct foo *src)\n"));
+    spg_context_destroy(context);
+    // with --preprocess a later call can reuse the name of a buffer.
+    context = spg_context_create();
+    assert(context);
+    spg_set_options(context, spg_option_preprocess | spg_option_no_includes);
+    const char *first = "generate_properties struct first_call { int x; };";
+    const char *second = "generate_properties struct second_call { int y; };";
+    assert(spg_add_buffer(context, "reused.h", first, strlen(first)));
+    spg_generate(context, &sink);
+    generated.len = 0;
+    assert(spg_add_buffer(context, "reused.h", second, strlen(second)));
+    spg_generate(context, &sink);
+    assert(strstr(generated.text, "int print_second_call(char *dest, int n, const struct second_call *src)\n"));
+    spg_context_destroy(context);
+    printf("\n\n");
+#endif
+
+#ifdef INSTRUMENT
+    print_counters(counters_buf, sizeof(counters_buf), &c);
+    spg_dump_stats(stdout);
+    assert(spg_stats_some_other_struct.calls == 3);
+    assert(spg_stats_some_other_struct.bytes == strlen(buf) + strlen("st.foo:"));
+    // the small buffer and measuring without one.
+    assert(spg_stats_some_other_struct.truncations == 2);
+    assert(spg_stats_counters.calls == 4);
+    assert(spg_stats_counters.bytes == 2 * strlen(counters_buf) + strlen("misses: 2\ntime.started: 100\ntime.finished: 250\n"));
+    assert(spg_stats_counters.truncations == 0);
+    // called by some_other_struct (3 times), nested_types and spg_print.
+    assert(spg_stats_struct_as_type.calls == 5);
+    assert(spg_stats_foo.calls == 2);
+    assert(spg_stats_foo.truncations == 1);
+    printf("\n\n");
+#endif
     printf("test succeed!\n");
     return 0;
 }
\ No newline at end of file